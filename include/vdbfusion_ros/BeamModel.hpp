@@ -0,0 +1,106 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LeafStamps.hpp"
+#include "ScanBuffer.hpp"
+#include "sophus/se3.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// A sweep decoded against a BeamModel: the beam index and measured range of every valid return
+struct BeamScan {
+    std::vector<uint32_t> beams;
+    std::vector<float> ranges;
+};
+
+// Fixed beam layout of an organized sensor (Ouster, Velodyne, ...). The unit direction of every
+// beam is learned from the first sweeps or loaded from disk, so integration no longer has to
+// re-derive the ray setup from xyz for every point.
+class BeamModel {
+public:
+    struct Ray {
+        Eigen::Vector3d direction;
+        Eigen::Vector3d inv_direction;
+        Eigen::Vector3d t_delta;
+        Eigen::Vector3i step;
+    };
+
+    // A sweep decodes only if every kept point lies within max_angular_error (radians) of its
+    // learned beam direction
+    BeamModel(int learning_scans, double max_angular_error)
+        : learning_scans_(learning_scans), min_cos_error_(std::cos(max_angular_error)) {}
+
+    bool Load(const std::string& filename);
+    bool Save(const std::string& filename) const;
+
+    // Accumulates the directions of an organized sweep, returns true once the model is ready
+    bool Learn(const ScanBuffer& organized_scan);
+    bool Ready() const { return !directions_.empty() && learned_scans_ >= learning_scans_; }
+    bool Matches(const ScanBuffer& organized_scan) const {
+        return directions_.size() == organized_scan.size();
+    }
+
+    // Keeps the beams selected by the keep mask of the sweep (see ComputeKeepMask). Returns false
+    // if the sweep does not match the learned layout, or if one of its points left its beam:
+    // deskewed clouds and sensors whose azimuth varies from sweep to sweep have to be raycast.
+    bool Decode(const ScanBuffer& organized_scan, BeamScan& scan) const;
+
+    // World frame rays of the given beams, indexed by beam. A ray is only recomputed if the
+    // sensor orientation changed since it was last set up, and the other beams are left stale:
+    // a moving platform pays for the beams with a return, not for the whole layout.
+    const std::vector<Ray>& Orient(const Eigen::Matrix3d& R_world_sensor,
+                                   double voxel_size,
+                                   const std::vector<uint32_t>& beams);
+
+private:
+    int learning_scans_;
+    double min_cos_error_;
+    int learned_scans_ = 0;
+    std::vector<Eigen::Vector3d> directions_;
+
+    Eigen::Matrix3d cached_rotation_ = Eigen::Matrix3d::Zero();
+    double cached_voxel_size_ = 0.0;
+    // Rays are valid for the orientation of generation_ if their entry matches it
+    uint32_t generation_ = 0;
+    std::vector<uint32_t> ray_generation_;
+    std::vector<Ray> rays_;
+};
+
+// Raycasting TSDF update driven by the cached per-beam directions and DDA step constants. The
+// leaves of the updated voxels are added to touched.
+void IntegrateBeams(VDBVolume& volume,
+                    BeamModel& beam_model,
+                    const BeamScan& scan,
+                    const Sophus::SE3d& T_world_sensor,
+                    const std::function<float(float)>& weighting_function,
+                    TouchedLeaves& touched);
+}  // namespace vdbfusion
@@ -0,0 +1,42 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include <cstddef>
+
+#include "ScanBuffer.hpp"
+
+namespace vdbfusion {
+
+// Single pass decode into the SoA scan, returns the number of invalid (non-finite or zero range)
+// points. Clouds that are not dense are compacted while decoding unless keep_layout is set, in
+// which case the (row, column) order is preserved and the invalid points are left to the filters.
+// Big endian clouds are byte swapped. A cloud whose data is shorter than height * row_step, whose
+// rows are shorter than width * point_step or whose fields overrun point_step is dropped with a
+// warning and leaves the scan empty.
+size_t pcl2SensorMsgToScanBuffer(const sensor_msgs::PointCloud2& pcl2,
+                                 ScanBuffer& scan,
+                                 bool keep_layout);
+}  // namespace vdbfusion
@@ -0,0 +1,118 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "ScanBatch.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// TSDF volume that stores {tsdf, weight} as a single Vec2f per voxel. VDBVolume walks the tsdf
+// and the weights tree for every update and touches two leaf buffers, here both values come out
+// of one accessor lookup and one leaf.
+class FusedVolumeBase {
+public:
+    FusedVolumeBase(float voxel_size, float sdf_trunc, bool space_carving)
+        : voxel_size_(voxel_size), sdf_trunc_(sdf_trunc), space_carving_(space_carving) {}
+    virtual ~FusedVolumeBase() = default;
+
+    // Same traversal and update rule as VDBVolume::Integrate: single precision ray and DDA, the
+    // same voxel centers and signed distances, so both layouts hold the same values
+    virtual void Integrate(const std::vector<Eigen::Vector3d>& points,
+                           const Eigen::Vector3d& origin,
+                           const std::function<float(float)>& weighting_function) = 0;
+
+    // Integrates every scan of the batch through a single accessor
+    virtual void Integrate(const ScanBatch& batch,
+                           const std::function<float(float)>& weighting_function) = 0;
+
+    // Same with vdbfusion's constant weighting, which is inlined into the voxel loop instead of
+    // being called through the std::function for every voxel
+    virtual void Integrate(const ScanBatch& batch) = 0;
+
+    // Copies the volume into the two grid layout, used for meshing and for saving
+    virtual VDBVolume Split() const = 0;
+
+    // Copies the voxels of the float grid leaf at tsdf.origin() into tsdf and weights, which
+    // must hold the background values. Returns false if none of them is active.
+    using FloatLeafT = openvdb::FloatTree::LeafNodeType;
+    virtual bool CopyLeaf(FloatLeafT& tsdf, FloatLeafT& weights) const = 0;
+
+    // Appends the origins of the float grid leaves that hold the voxels of the volume, a leaf
+    // smaller than a float leaf may repeat the origin of another
+    virtual void LeafOrigins(std::vector<openvdb::Coord>& origins) const = 0;
+
+public:
+    float voxel_size_;
+    float sdf_trunc_;
+    bool space_carving_;
+};
+
+// Leaves of (1 << Log2Dim)^3 voxels. The dispatch is virtual once per scan, the voxel loops are
+// compiled for every leaf size.
+template <openvdb::Index Log2Dim>
+class FusedVolume final : public FusedVolumeBase {
+public:
+    using TreeT = typename openvdb::tree::Tree4<openvdb::Vec2f, 5, 4, Log2Dim>::Type;
+    using GridT = openvdb::Grid<TreeT>;
+
+    FusedVolume(float voxel_size, float sdf_trunc, bool space_carving = false);
+
+    void Integrate(const std::vector<Eigen::Vector3d>& points,
+                   const Eigen::Vector3d& origin,
+                   const std::function<float(float)>& weighting_function) override;
+    void Integrate(const ScanBatch& batch,
+                   const std::function<float(float)>& weighting_function) override;
+    void Integrate(const ScanBatch& batch) override;
+    VDBVolume Split() const override;
+    bool CopyLeaf(FloatLeafT& tsdf, FloatLeafT& weights) const override;
+    void LeafOrigins(std::vector<openvdb::Coord>& origins) const override;
+
+private:
+    template <typename Weighting>
+    void IntegrateScan(typename GridT::UnsafeAccessor& acc,
+                       const std::vector<Eigen::Vector3d>& points,
+                       const Eigen::Vector3d& origin,
+                       const Weighting& weighting_function);
+
+public:
+    typename GridT::Ptr grid_;
+};
+
+extern template class FusedVolume<2>;
+extern template class FusedVolume<3>;
+extern template class FusedVolume<4>;
+
+// leaf_dim is the number of voxels along a leaf edge: 4, 8 or 16. Returns nullptr otherwise.
+std::unique_ptr<FusedVolumeBase> MakeFusedVolume(int leaf_dim,
+                                                 float voxel_size,
+                                                 float sdf_trunc,
+                                                 bool space_carving);
+}  // namespace vdbfusion
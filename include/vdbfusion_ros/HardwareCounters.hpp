@@ -0,0 +1,62 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+namespace vdbfusion {
+
+enum class Counter { kCycles, kInstructions, kLLCMisses, kDTLBMisses, kBranchMisses };
+constexpr size_t kCounterCount = 5;
+
+const char* CounterName(Counter counter);
+
+using CounterValues = std::array<uint64_t, kCounterCount>;
+
+// User space hardware counters (perf_event_open) of every thread that takes part in the scan
+// pipeline: the threads running its stages and the TBB workers they hand work to. Each thread
+// gets its own counter group the first time it shows up, and Read sums all of them, so the
+// difference of two reads covers the work of a stage wherever it ran. Work the TBB workers do for
+// other callers in the meantime is counted as well.
+//
+// Until Enable succeeds nothing is opened and Read returns false right away.
+class HardwareCounters {
+public:
+    static HardwareCounters& Instance();
+
+    // Returns false if the kernel, its perf_event_paranoid setting, the container or a virtual
+    // machine without PMU does not let the process count its own cycles
+    bool Enable();
+    bool Enabled() const;
+
+    // Counters the CPU does not offer read as 0
+    bool Available(Counter counter) const;
+
+    // Opens the counters of the calling thread if it has none yet
+    void AttachThread();
+
+    bool Read(CounterValues& values);
+};
+}  // namespace vdbfusion
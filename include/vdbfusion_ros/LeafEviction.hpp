@@ -0,0 +1,72 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <cstddef>
+#include <vector>
+
+#include "LeafStamps.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+struct EvictionStats {
+    size_t evicted_leaves;
+    size_t evicted_voxels;
+    size_t remaining_leaves;
+};
+
+// Drops the leaves left behind by transient objects: every voxel below max_weight and no update
+// for max_age seconds. The integration paths report the leaves they write through Touch, so a
+// pass only looks at the leaves written within max_age plus the candidates waiting to age, never
+// at the whole map.
+class TransientLeafEvictor {
+public:
+    TransientLeafEvictor(float max_weight, double max_age)
+        : max_weight_(max_weight), max_age_(max_age) {}
+
+    // The leaves were written at time stamp (seconds), origins sorted without duplicates
+    void Touch(const std::vector<openvdb::Coord>& origins, double stamp);
+
+    // One pass at time now, in the time base of the stamps. Must not overlap with integration.
+    // The evicted leaves are added to removed.
+    EvictionStats Evict(VDBVolume& volume, double now, TouchedLeaves& removed);
+
+private:
+    struct TrackedLeaf {
+        openvdb::Coord origin;
+        double last_update;
+    };
+
+    float max_weight_;
+    double max_age_;
+    // Sorted by origin. A leaf leaves the list once it is evicted or holds a voxel of at least
+    // max_weight, it comes back with its next update.
+    std::vector<TrackedLeaf> tracked_;
+    // Touched since the last pass, in the order reported
+    std::vector<TrackedLeaf> pending_;
+    std::vector<TrackedLeaf> merged_;
+};
+}  // namespace vdbfusion
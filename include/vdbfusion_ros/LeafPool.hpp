@@ -0,0 +1,83 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <cstddef>
+
+namespace vdbfusion {
+
+struct LeafPoolStats {
+    size_t slabs;
+    size_t reserved_bytes;
+    size_t live_blocks;
+    size_t allocations;
+    size_t deallocations;
+    double refill_seconds;
+};
+
+// Slab allocator for the two allocations every OpenVDB float (or fused Vec2f) leaf makes: the
+// LeafNode itself and its 512 voxel buffer. Blocks come out of 2 MB slabs carved from a single
+// reserved region, optionally backed by transparent huge pages, and freed leaves (pruning,
+// eviction) go back to per-size free lists instead of the system allocator.
+//
+// OpenVDB allocates its leaves with plain new, and the grid types are fixed by vdbfusion, so the
+// pool is reached through the allocation hooks of LeafPoolHooks.cpp. Only the executables that
+// link them can enable the pool, and even there it only serves leaf sized requests made inside a
+// LeafAllocationScope. Everything else goes to malloc.
+class LeafPool {
+public:
+    static LeafPool& Instance();
+
+    // Leaves allocated before stay with the system allocator. Later calls keep the first
+    // reservation. Returns false if the address space cannot be reserved or the hooks are not
+    // linked.
+    bool Enable(size_t reserve_bytes, bool huge_pages);
+    bool Enabled() const;
+
+    // Return nullptr / false if the request is not served by the pool
+    void* Allocate(size_t size);
+    bool Deallocate(void* ptr);
+
+    LeafPoolStats Stats() const;
+};
+
+// Lets the pool serve the leaf sized allocations of the calling thread while it lives. Opened
+// around the calls that add leaves to the volume, which all allocate them on the calling thread.
+class LeafAllocationScope {
+public:
+    LeafAllocationScope();
+    ~LeafAllocationScope();
+    LeafAllocationScope(const LeafAllocationScope&) = delete;
+    LeafAllocationScope& operator=(const LeafAllocationScope&) = delete;
+};
+
+// Resident set size of the current process in bytes, read from /proc/self/statm
+size_t ResidentSetSize();
+
+// High water mark of the resident set size in bytes (VmHWM of /proc/self/status)
+size_t PeakResidentSetSize();
+
+// Restarts the high water mark from the current resident set size. Returns false if the kernel
+// does not support it, the peak then covers the whole life of the process.
+bool ResetPeakResidentSetSize();
+}  // namespace vdbfusion
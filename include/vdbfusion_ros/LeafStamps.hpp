@@ -0,0 +1,67 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <array>
+#include <vector>
+
+#include "ScanBatch.hpp"
+
+namespace vdbfusion {
+
+// Origins of the float grid leaves written by the integration steps, reported by the writers
+// themselves so that nobody has to walk the map to find out what changed. Leaves reported
+// shortly before are skipped, duplicates that get through are removed by Sorted().
+class TouchedLeaves {
+public:
+    TouchedLeaves() { clear(); }
+
+    void Add(const openvdb::Coord& leaf_origin) {
+        openvdb::Coord& recent = recent_[leaf_origin.hash<kRecentLog2>()];
+        if (recent != leaf_origin) {
+            recent = leaf_origin;
+            origins_.push_back(leaf_origin);
+        }
+    }
+
+    // Leaves that VDBVolume::Integrate, the fused layout or the packets may write when
+    // integrating the batch: the truncation band around every point, and the leaves crossed by
+    // the whole ray when carving free space
+    void AddRays(const openvdb::FloatGrid& grid,
+                 float sdf_trunc,
+                 bool space_carving,
+                 const ScanBatch& batch);
+
+    // Sorted by origin, without duplicates
+    const std::vector<openvdb::Coord>& Sorted();
+    bool empty() const { return origins_.empty(); }
+    void clear();
+
+private:
+    static constexpr int kRecentLog2 = 6;
+    std::vector<openvdb::Coord> origins_;
+    std::array<openvdb::Coord, 1 << kRecentLog2> recent_;
+};
+}  // namespace vdbfusion
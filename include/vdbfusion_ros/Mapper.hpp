@@ -0,0 +1,195 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "BeamModel.hpp"
+#include "FusedVolume.hpp"
+#include "LeafEviction.hpp"
+#include "PipelineStats.hpp"
+#include "RangeImage.hpp"
+#include "ScanArena.hpp"
+#include "ScanBuffer.hpp"
+#include "ScanHistory.hpp"
+#include "VolumeSnapshot.hpp"
+#include "VolumeStream.hpp"
+#include "sophus/se3.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// Everything the mapping pipeline needs to know, filled from the ROS parameters by the node or
+// directly by benchmarks and batch tools. Angles are in radians and durations in seconds.
+struct MapperConfig {
+    // VDBFusion
+    float voxel_size = 0.1f;
+    float sdf_trunc = 0.3f;
+    bool space_carving = false;
+    // Leaf allocation, see LeafPool
+    bool leaf_pool = false;
+    size_t leaf_pool_reserve_bytes = size_t(64) << 30;
+    bool leaf_pool_huge_pages = true;
+
+    // PointCloud Processing
+    bool apply_pose = true;
+    PointFilter filter;
+    float voxel_filter_size = 0.0f;
+
+    // Integration
+    bool projective = false;
+    // 64 rings from +2 to -24.8 degrees
+    LiDARIntrinsics lidar{64, 2048, 0.034907f, -0.432842f, {}};
+    bool ray_packets = false;
+    int batch_scans = 1;
+    // Sensor time after which a partial batch is integrated, 0 waits for batch_scans
+    double batch_latency = 0.0;
+    bool fused_layout = false;
+    int leaf_dim = 8;
+
+    // Fixed-layout sensors
+    bool beam_model = false;
+    int beam_model_learning_scans = 10;
+    // Largest angle between a point and its learned beam before the scan is raycast instead
+    double beam_model_tolerance = 0.0174533;
+    std::string beam_model_file;
+
+    // Time Window and Pose Corrections
+    double window_duration = 0.0;
+    bool pose_corrections = false;
+    double correction_tolerance = 0.0;
+    double correction_translation = 0.05;
+    double correction_rotation = 0.0174533;
+
+    // Transient Leaf Eviction
+    bool eviction = false;
+    // Seconds between the passes of whoever calls EvictTransients
+    double eviction_period = 0.0;
+    float eviction_max_weight = 2.0f;
+    double eviction_age = 30.0;
+
+    // Snapshots, see SnapshotWriter. Retaining keeps a second copy of every leaf resident.
+    bool retain_snapshots = false;
+
+    // Leaf Streaming
+    bool stream_deltas = false;
+
+    // Triangle Mesh Extraction
+    bool fill_holes = true;
+    float min_weight = 0.0f;
+
+    // Per-stage hardware counters, see HardwareCounters
+    bool hardware_counters = false;
+};
+
+// Fills the sensor frame scan of the Mapper, whose buffers are reused between scans. keep_layout
+// asks for the (row, column) order of organized scans, returns whether the scan keeps it.
+using ScanDecoder = std::function<bool(ScanBuffer& scan, bool keep_layout)>;
+
+// The mapping pipeline without any ROS plumbing: filtering, integration, the scan history,
+// eviction, streaming and export. Message conversion lives in MapperMsgs. All methods may be
+// called from any thread, they are serialized on the volume.
+class Mapper {
+public:
+    explicit Mapper(const MapperConfig& config);
+
+    // The configuration in use, with the options the other settings rule out switched off
+    const MapperConfig& config() const { return config_; }
+
+    // Integrates the scan decode fills, taken at stamp from the given sensor pose. Without
+    // apply_pose the pose is ignored and the scan is integrated in the sensor frame. Raycast scans
+    // may be held back until their batch is complete.
+    void Integrate(const ScanDecoder& decode, double stamp, const Sophus::SE3d& pose);
+
+    // Integrates the scans still waiting in the batch
+    void Flush();
+
+    // Moves the recorded scans to their corrected poses, returns the number of scans moved
+    size_t CorrectPoses(const std::vector<PoseCorrection>& corrections);
+
+    // Drops the transient leaves, now is in the time base of the scan stamps
+    EvictionStats EvictTransients(double now);
+    // Same at the stamp of the last integrated scan, which ages the leaves in sensor time even
+    // when the scans are played back slower or faster than the wall clock
+    EvictionStats EvictTransients();
+
+    // Leaves changed since the previous delta, nearest to the last sensor position first. Returns
+    // false if nothing changed and no resync is pending.
+    bool EncodeDelta(size_t budget_bytes, LeafDelta& delta);
+    void ResetDeltas();
+
+    // Read-only view of the volume that stays valid while integration goes on. Only the leaves
+    // that changed since the previous snapshot are copied.
+    std::shared_ptr<const VolumeSnapshot> Snapshot();
+
+    // Time spent in the stages of the scan pipeline
+    PipelineStats Stats();
+    void ResetStats();
+
+    // Writes the grids and the mesh of a snapshot, integration only waits for the snapshot itself
+    void Save(const std::string& prefix);
+
+private:
+    void IntegrateBatch();
+    // Takes the scans in arena_.expired out of the volume
+    void DeintegrateExpired();
+    // Reports the leaves in arena_.touched to the snapshots and the evictor
+    void CommitTouched();
+    // EvictTransients with the volume lock held
+    EvictionStats Evict(double now);
+
+private:
+    MapperConfig config_;
+    VDBVolume vdb_volume_;
+    // Single grid {tsdf, weight} layout, replaces vdb_volume_ when set
+    std::unique_ptr<FusedVolumeBase> fused_volume_;
+    ScanArena arena_;
+    // Held by whatever modifies or walks the live volume. Readers only hold it while a snapshot
+    // is taken.
+    std::mutex volume_mutex_;
+    SnapshotWriter snapshots_;
+    // The ray packets inline the same unit weight
+    std::function<float(float)> weighting_function_ = [](float /*unused*/) { return 1.0f; };
+    PipelineStats stats_;
+
+    double batch_start_ = 0.0;
+    // Integrated scans, kept for the time window and the pose corrections
+    std::unique_ptr<ScanHistory> history_;
+    std::unique_ptr<RangeImage> range_image_;
+    std::unique_ptr<BeamModel> beam_model_;
+    std::unique_ptr<TransientLeafEvictor> evictor_;
+    // Held across a whole delta and by a resync, the encoder is not shared otherwise
+    std::mutex delta_mutex_;
+    LeafDeltaEncoder delta_encoder_;
+    Eigen::Vector3d last_origin_ = Eigen::Vector3d::Zero();
+    // Header stamp of the last scan, the time of the leaf updates for the eviction
+    double last_stamp_ = 0.0;
+    bool warned_beam_mismatch_ = false;
+};
+}  // namespace vdbfusion
@@ -0,0 +1,42 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <sensor_msgs/PointCloud2.h>
+
+#include "Mapper.hpp"
+#include "VolumeStream.hpp"
+#include "sophus/se3.hpp"
+#include "vdbfusion_ros/VolumeDelta.h"
+
+namespace vdbfusion {
+
+// Decodes the cloud into the Mapper and integrates it at its header stamp
+void IntegrateCloud(Mapper& mapper, const sensor_msgs::PointCloud2& pcd, const Sophus::SE3d& pose);
+
+// Swaps the buffers of delta into the message, so neither side reallocates between deltas
+void SwapIntoMsg(LeafDelta& delta, vdbfusion_ros::VolumeDelta& msg);
+
+void FromMsg(const vdbfusion_ros::VolumeDelta& msg, LeafDelta& delta);
+}  // namespace vdbfusion
@@ -0,0 +1,46 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+namespace vdbfusion {
+
+// Read access to the flat parameters of config/*.yaml, from the parameter server or straight from
+// the file. Names are given without the leading slash.
+class ParamSource {
+public:
+    virtual ~ParamSource() = default;
+
+    // Return false and leave the value untouched if the parameter is not set or of another type
+    virtual bool Get(const std::string& name, bool& value) const = 0;
+    virtual bool Get(const std::string& name, int& value) const = 0;
+    virtual bool Get(const std::string& name, float& value) const = 0;
+    virtual bool Get(const std::string& name, double& value) const = 0;
+    virtual bool Get(const std::string& name, std::string& value) const = 0;
+    virtual bool Get(const std::string& name, std::vector<float>& value) const = 0;
+    // Lists of number lists such as the crop boxes, malformed entries are skipped
+    virtual bool Get(const std::string& name, std::vector<std::vector<float>>& value) const = 0;
+};
+}  // namespace vdbfusion
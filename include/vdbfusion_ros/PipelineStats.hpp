@@ -0,0 +1,87 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+#include "HardwareCounters.hpp"
+
+namespace vdbfusion {
+
+// Stages of the scan pipeline inside the Mapper
+enum class Stage { kDecode, kFilter, kTransform, kIntegrate, kDeintegrate };
+constexpr size_t kStageCount = 5;
+
+const char* StageName(Stage stage);
+
+struct StageStats {
+    size_t calls = 0;
+    double seconds = 0.0;
+    // Hardware counters, all 0 unless they are enabled, see HardwareCounters
+    CounterValues counters{};
+};
+
+// Wall clock time and hardware counters of every stage since the last Reset
+class PipelineStats {
+public:
+    void Add(Stage stage, double seconds, const CounterValues* counters = nullptr) {
+        auto& stats = stages_[static_cast<size_t>(stage)];
+        ++stats.calls;
+        stats.seconds += seconds;
+        if (counters) {
+            for (size_t i = 0; i < kCounterCount; ++i) {
+                stats.counters[i] += (*counters)[i];
+            }
+        }
+    }
+    const StageStats& operator[](Stage stage) const { return stages_[static_cast<size_t>(stage)]; }
+    void Reset() { stages_ = {}; }
+
+private:
+    std::array<StageStats, kStageCount> stages_;
+};
+
+// One line per stage with its time and, if the counters are enabled, IPC and the misses per
+// thousand instructions
+std::string FormatSummary(const PipelineStats& stats);
+
+// Adds the time and the hardware counters of its scope to a stage. The counters cost two reads
+// per thread that ever ran a stage or a TBB task, with them disabled only the clock is read.
+class ScopedStage {
+public:
+    ScopedStage(PipelineStats& stats, Stage stage);
+    ~ScopedStage();
+    ScopedStage(const ScopedStage&) = delete;
+    ScopedStage& operator=(const ScopedStage&) = delete;
+
+private:
+    PipelineStats& stats_;
+    Stage stage_;
+    bool counting_;
+    CounterValues start_counters_;
+    std::chrono::steady_clock::time_point start_;
+};
+}  // namespace vdbfusion
@@ -0,0 +1,87 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <geometry_msgs/Transform.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/time.h>
+
+#include <Eigen/Core>
+#include <deque>
+#include <mutex>
+
+#include "ParamSource.hpp"
+#include "sophus/se3.hpp"
+
+inline Sophus::SE3d TransformToSE3(const geometry_msgs::Transform& tf) {
+    return {Eigen::Quaterniond{tf.rotation.w, tf.rotation.x, tf.rotation.y, tf.rotation.z},
+            Eigen::Vector3d{tf.translation.x, tf.translation.y, tf.translation.z}};
+}
+
+inline geometry_msgs::Transform SE3ToTransform(const Sophus::SE3d T) {
+    auto t = T.translation();
+    auto q = T.unit_quaternion();
+
+    geometry_msgs::Transform tf;
+    tf.translation.x = t.x();
+    tf.translation.y = t.y();
+    tf.translation.z = t.z();
+    tf.rotation.w = q.w();
+    tf.rotation.x = q.x();
+    tf.rotation.y = q.y();
+    tf.rotation.z = q.z();
+    return tf;
+}
+
+namespace vdbfusion {
+
+// Time ordered queue of the tracked frame poses, interpolated at the scan timestamps. It does not
+// talk to ROS, poses are fed by whoever receives them.
+class PoseBuffer {
+public:
+    // The static transform is the pose of the tracked frame in the sensor frame, it is removed
+    // from every pose that is looked up
+    void SetStaticTransform(const geometry_msgs::Transform& static_tf);
+
+    void Add(const geometry_msgs::TransformStamped& transform);
+
+    // Poses older than the returned one are dropped, scans are expected in time order
+    bool Lookup(const ros::Time& timestamp,
+                const ros::Duration& tolerance,
+                geometry_msgs::TransformStamped& transform);
+
+    size_t size() const;
+
+private:
+    // The queue is filled by the pose callbacks and drained by the lookups, which may run on
+    // different threads
+    mutable std::mutex mutex_;
+    std::deque<geometry_msgs::TransformStamped,
+               Eigen::aligned_allocator<geometry_msgs::TransformStamped>>
+        queue_;
+    geometry_msgs::Transform static_tf_ = SE3ToTransform(Sophus::SE3d());
+};
+
+// Pose of the tracked frame in the sensor frame (tx, ty, tz, x, y, z, w and invert_static_tf)
+geometry_msgs::Transform ReadStaticTransform(const ParamSource& params);
+}  // namespace vdbfusion
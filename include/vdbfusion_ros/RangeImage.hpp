@@ -0,0 +1,94 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ScanBuffer.hpp"
+#include "sophus/se3.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// Beam layout of a spinning LiDAR. Angles are in radians. If beam_elevations is empty the rings
+// are assumed to be evenly spread between fov_down and fov_up.
+struct LiDARIntrinsics {
+    int rings;
+    int azimuth_bins;
+    float fov_up;
+    float fov_down;
+    std::vector<float> beam_elevations;
+};
+
+// (ring x azimuth) spherical projection of a single LiDAR sweep, expressed in the sensor frame.
+class RangeImage {
+public:
+    explicit RangeImage(const LiDARIntrinsics& intrinsics);
+
+    void Build(const ScanBuffer& scan);
+
+    // Returns the pixel index of a sensor frame point, or -1 if it falls outside the image
+    int Project(const Eigen::Vector3f& point) const;
+
+    float Range(int pixel) const { return ranges_[pixel]; }
+    const Eigen::Vector3f& Point(int pixel) const { return points_[pixel]; }
+    const std::vector<int>& ValidPixels() const { return valid_pixels_; }
+
+private:
+    int RingFromElevation(float elevation) const;
+
+private:
+    int rings_;
+    int cols_;
+
+    // Precomputed beam-angle table: elevation bin -> nearest ring index
+    std::vector<int16_t> elevation_lut_;
+    float lut_min_elevation_;
+    float lut_inv_resolution_;
+
+    std::vector<float> ranges_;
+    std::vector<Eigen::Vector3f> points_;
+    std::vector<int> valid_pixels_;
+};
+
+// Candidate leaf bookkeeping of IntegrateProjective, kept by the caller so that its storage is
+// recycled from one scan to the next
+struct ProjectiveScratch {
+    std::vector<openvdb::Coord> leaf_origins;
+    std::vector<openvdb::FloatTree::LeafNodeType*> tsdf_leaves;
+    std::vector<openvdb::FloatTree::LeafNodeType*> weights_leaves;
+    std::vector<uint8_t> created;
+    std::vector<openvdb::Index> n_updates;
+};
+
+// Projective TSDF update: every voxel close to the observed surface is projected once into the
+// range image instead of traversing one ray per point.
+void IntegrateProjective(VDBVolume& volume,
+                         const RangeImage& range_image,
+                         const Sophus::SE3d& T_world_sensor,
+                         const std::function<float(float)>& weighting_function,
+                         ProjectiveScratch& scratch);
+}  // namespace vdbfusion
@@ -0,0 +1,99 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "ScanBatch.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+struct PacketRay {
+    uint64_t leaf_key;  // Leaf of the endpoint
+    uint32_t scan;
+    uint32_t point;
+
+    bool operator<(const PacketRay& other) const {
+        return leaf_key != other.leaf_key ? leaf_key < other.leaf_key
+               : scan != other.scan       ? scan < other.scan
+                                          : point < other.point;
+    }
+};
+
+// Per-batch storage of IntegratePackets, recycled from one batch to the next
+struct PacketScratch {
+    // Sorted by leaf so that consecutive packets hit the same leaves
+    std::vector<PacketRay> order;
+    // Sensor origins of the batch in index space
+    std::vector<Eigen::Vector3d> eyes;
+    // Traversal results of one packet, step major ([step * width + lane]) so that every lane
+    // loop stores contiguously
+    std::vector<int32_t> vx;
+    std::vector<int32_t> vy;
+    std::vector<int32_t> vz;
+    std::vector<float> sdf;
+};
+
+// Truncation band integration of a batch of scans in packets of kPacketWidth rays. The traversal
+// and the signed distances are computed on Eigen arrays with one lane per ray, which map to SSE,
+// AVX2 or AVX-512 packets depending on the target, the grid updates are then applied ray after
+// ray. The rays of all scans of the batch share one pair of accessors and are ordered by the leaf
+// of their endpoint, so a packet mostly writes to the same few leaves.
+//
+// The result only depends on that ray order, not on the packet width: packet_width = 1 is the
+// scalar fallback and gives bit identical grids (any other width means kPacketWidth). Against
+// VDBVolume::Integrate, which traverses in single precision, a ray whose band starts or ends
+// within rounding of a voxel face may visit one voxel more or less, and rays running inside a
+// face plane can land on the other side of it. RayPacketsTest bounds the difference. Volumes
+// with space carving go through VDBVolume::Integrate scan by scan, the packets only pay off when
+// the rays are short.
+constexpr int kPacketWidth = 8;
+void IntegratePackets(VDBVolume& volume,
+                      const ScanBatch& batch,
+                      const std::function<float(float)>& weighting_function,
+                      PacketScratch& scratch,
+                      int packet_width = kPacketWidth);
+
+// Same with vdbfusion's constant unit weight, which is inlined into the update loop instead of
+// calling a std::function for every voxel
+void IntegratePackets(VDBVolume& volume,
+                      const ScanBatch& batch,
+                      PacketScratch& scratch,
+                      int packet_width = kPacketWidth);
+
+// Subtracts the truncation band contributions of a batch that was integrated before by
+// IntegratePackets, with the same points and weighting function. VDBVolume::Integrate traverses
+// in single precision and may visit other voxels, its contributions cannot be taken out here.
+// The free space carved along the rays is not replayed either.
+void DeintegratePackets(VDBVolume& volume,
+                        const ScanBatch& batch,
+                        const std::function<float(float)>& weighting_function,
+                        PacketScratch& scratch);
+void DeintegratePackets(VDBVolume& volume, const ScanBatch& batch, PacketScratch& scratch);
+}  // namespace vdbfusion
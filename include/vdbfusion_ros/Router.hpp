@@ -0,0 +1,62 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "ScanBuffer.hpp"
+#include "Sharding.hpp"
+#include "Transform.hpp"
+
+namespace vdbfusion {
+// Splits every scan by the shard owning the world position of each point and forwards the parts
+// to /shard_<id>/points. Points keep their raw layout and the header of the scan, so each shard
+// looks up the same pose and integrates its part as an ordinary, smaller scan.
+class ScanRouter {
+public:
+    ScanRouter();
+
+private:
+    void Route(const sensor_msgs::PointCloud2& pcd);
+
+private:
+    ros::NodeHandle nh_;
+    ros::Subscriber sub_;
+    std::vector<ros::Publisher> shard_pubs_;
+    Transform tf_;
+    ros::Duration timestamp_tolerance_;
+
+private:
+    ShardLayout layout_;
+    bool apply_pose_;
+
+    // Reused between scans
+    ScanBuffer scan_;
+    std::vector<Eigen::Vector3d> world_points_;
+    std::vector<sensor_msgs::PointCloud2> shard_scans_;
+};
+}  // namespace vdbfusion
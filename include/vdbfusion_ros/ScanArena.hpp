@@ -0,0 +1,52 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <vector>
+
+#include "BeamModel.hpp"
+#include "LeafStamps.hpp"
+#include "RangeImage.hpp"
+#include "RayPackets.hpp"
+#include "ScanBatch.hpp"
+#include "ScanBuffer.hpp"
+
+namespace vdbfusion {
+
+// Per-scan temporaries. The buffers are cleared but never shrunk between scans, so once the
+// largest scan has been seen decoding, filtering and integration no longer touch the heap.
+struct ScanArena {
+    // Sensor frame scan, single precision from decoding to the integration boundary
+    ScanBuffer scan;
+    // World frame scans waiting to be integrated
+    ScanBatch batch;
+    // Scans leaving the time window or moved by a pose correction, to be de-integrated
+    ScanBatch expired;
+    BeamScan beam_scan;
+    ProjectiveScratch projective;
+    PacketScratch packets;
+    // Leaves written since they were last reported to the snapshots
+    TouchedLeaves touched;
+};
+}  // namespace vdbfusion
@@ -0,0 +1,53 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <vector>
+
+namespace vdbfusion {
+
+// World frame points of one or more posed scans that are integrated together. Clearing the batch
+// keeps the point buffers, so refilling it does not allocate once the largest scans were seen.
+class ScanBatch {
+public:
+    size_t size() const { return origins.size(); }
+    bool empty() const { return origins.empty(); }
+    void clear() { origins.clear(); }
+
+    // Point buffer of a new scan observed from origin
+    std::vector<Eigen::Vector3d>& Add(const Eigen::Vector3d& origin) {
+        if (points.size() == origins.size()) {
+            points.emplace_back();
+        }
+        origins.push_back(origin);
+        return points[origins.size() - 1];
+    }
+
+public:
+    // points[i] was observed from origins[i], entries past size() are spare storage
+    std::vector<std::vector<Eigen::Vector3d>> points;
+    std::vector<Eigen::Vector3d> origins;
+};
+}  // namespace vdbfusion
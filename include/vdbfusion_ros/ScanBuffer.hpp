@@ -0,0 +1,117 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <new>
+#include <vector>
+
+#include "sophus/se3.hpp"
+
+namespace vdbfusion {
+
+// Cache line aligned storage, wide enough for any SIMD register the filters get vectorized to
+template <typename T>
+struct AlignedAllocator {
+    using value_type = T;
+    static constexpr std::align_val_t alignment{64};
+
+    AlignedAllocator() = default;
+    template <typename U>
+    AlignedAllocator(const AlignedAllocator<U>& /*unused*/) {}
+
+    T* allocate(size_t n) { return static_cast<T*>(::operator new(n * sizeof(T), alignment)); }
+    void deallocate(T* ptr, size_t /*unused*/) { ::operator delete(ptr, alignment); }
+
+    template <typename U>
+    bool operator==(const AlignedAllocator<U>& /*unused*/) const {
+        return true;
+    }
+    template <typename U>
+    bool operator!=(const AlignedAllocator<U>& /*unused*/) const {
+        return false;
+    }
+};
+
+template <typename T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
+
+// Structure-of-arrays scan in the sensor frame. The optional channels are either empty or hold
+// one value per point. Filters evaluate a keep mask in a branch free pass over the coordinate
+// arrays and then compact every channel in a second pass.
+class ScanBuffer {
+public:
+    size_t size() const { return x.size(); }
+    bool empty() const { return x.empty(); }
+
+    void clear();
+    void resize(size_t n, bool with_intensity, bool with_time, bool with_ring);
+
+    // Drops the points whose keep mask entry is zero, preserving their order
+    void Compact();
+
+public:
+    AlignedVector<float> x;
+    AlignedVector<float> y;
+    AlignedVector<float> z;
+    AlignedVector<float> intensity;
+    AlignedVector<float> time;
+    AlignedVector<uint16_t> ring;
+
+    // Scratch space shared by the filters
+    AlignedVector<uint8_t> keep;
+    AlignedVector<uint64_t> voxel_table;
+};
+
+// Axis aligned box in the sensor frame
+struct CropBox {
+    Eigen::Vector3f min;
+    Eigen::Vector3f max;
+};
+
+// Sensor frame point selection. Non-finite and zero range points are always rejected.
+struct PointFilter {
+    float min_range = 0.0f;
+    float max_range = std::numeric_limits<float>::max();
+    // Points inside any of these boxes are dropped, e.g. the vehicle body and sensor mounts
+    std::vector<CropBox> exclusion_boxes;
+    // If not empty, only points inside at least one of these boxes are kept
+    std::vector<CropBox> inclusion_boxes;
+};
+
+// Evaluates the filter into scan.keep without moving any point. The range and box checks run
+// block by block in the same pass, so every box test hits coordinates already in L1.
+void ComputeKeepMask(ScanBuffer& scan, const PointFilter& filter);
+
+// ComputeKeepMask followed by the compaction of the scan
+void ApplyFilter(ScanBuffer& scan, const PointFilter& filter);
+
+// Keeps the first point of every voxel_size cube
+void VoxelFilter(ScanBuffer& scan, float voxel_size);
+
+// Integration boundary: rotates the scan in single precision and adds the translation in double
+void ToWorld(const ScanBuffer& scan, const Sophus::SE3d& T, std::vector<Eigen::Vector3d>& points);
+}  // namespace vdbfusion
@@ -0,0 +1,86 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+#include "ScanBatch.hpp"
+#include "sophus/se3.hpp"
+
+namespace vdbfusion {
+
+// Scan as integrated: the pose it was integrated with and the world frame endpoints relative to
+// the sensor origin, quantized to int16 with a per-scan step (6 bytes per point)
+struct ScanRecord {
+    double stamp;
+    Sophus::SE3d pose;
+    double step;
+    std::vector<int16_t> offsets;
+};
+
+struct PoseCorrection {
+    double stamp;
+    Sophus::SE3d pose;
+};
+
+// Integrated scans, in stamp order. A scan is quantized when it is recorded and the quantized
+// points are the ones that get integrated, so replaying a record visits exactly the voxels and
+// distances the scan contributed. That lets a scan be de-integrated when it leaves the time
+// window, or moved when its pose gets corrected.
+class ScanHistory {
+public:
+    // Scans older than duration before the newest one expire, duration <= 0 keeps every scan
+    explicit ScanHistory(double duration) : duration_(duration) {}
+
+    // Quantizes the world frame points in place and records them
+    void Add(double stamp, const Sophus::SE3d& pose, std::vector<Eigen::Vector3d>& points);
+
+    // Moves the expired scans into expired, returns false if there are none
+    bool Expire(ScanBatch& expired);
+
+    // Applies the corrections that match a recorded stamp within tolerance and move the scan by
+    // more than max_translation (meters) or max_rotation (radians). The points of those scans as
+    // they were integrated go to removed, and the corrected points, quantized and recorded in
+    // their place, go to added. A scan matched by several corrections takes the last of them.
+    // Returns the number of corrected scans.
+    size_t Correct(const std::vector<PoseCorrection>& corrections,
+                   double tolerance,
+                   double max_translation,
+                   double max_rotation,
+                   ScanBatch& removed,
+                   ScanBatch& added);
+
+    size_t size() const { return records_.size(); }
+    // Memory held by the recorded points
+    size_t bytes() const { return bytes_; }
+
+private:
+    double duration_;
+    size_t bytes_ = 0;
+    std::deque<ScanRecord> records_;
+};
+}  // namespace vdbfusion
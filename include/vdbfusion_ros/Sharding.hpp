@@ -0,0 +1,43 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <Eigen/Core>
+#include <string>
+
+namespace vdbfusion {
+
+// Static partition of the world into square x/y tiles of tile_size meters, every tile is owned by
+// one of the shards. The tiles are scattered over the shards by a hash of their coordinates, so a
+// trajectory that stays in one region of the map still spreads its load over all of them.
+struct ShardLayout {
+    int shards = 1;
+    double tile_size = 50.0;
+
+    // Shard owning the tile of a finite world point
+    int ShardOf(const Eigen::Vector3d& world_point) const;
+};
+
+// Namespace of the topics and services of a shard, "/shard_<id>"
+std::string ShardNamespace(int shard);
+}  // namespace vdbfusion
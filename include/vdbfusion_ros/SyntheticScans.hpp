@@ -0,0 +1,76 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <Eigen/Core>
+#include <cstdint>
+
+#include "sophus/se3.hpp"
+
+namespace vdbfusion {
+
+// Procedural scene for the benchmarks: an endless corridor with floor, ceiling, side walls and
+// square floor-to-ceiling pillars alternating between its two halves. Rays are intersected
+// analytically, so scans are cheap to render and identical from one run to the next.
+struct SyntheticScene {
+    double half_width = 6.0;
+    double height = 4.0;
+    double pillar_spacing = 8.0;
+    double pillar_half_size = 0.4;
+
+    // Distance to the first surface along a unit direction, max_range if there is none before
+    double Cast(const Eigen::Vector3d& origin,
+                const Eigen::Vector3d& direction,
+                double max_range) const;
+};
+
+struct SyntheticSensor {
+    enum class Model { kLiDAR, kDepthCamera };
+    Model model = Model::kLiDAR;
+    int rows = 64;
+    int columns = 1024;
+    // LiDAR rows span [fov_down, fov_up], columns a full turn
+    float fov_up = 0.034907f;
+    float fov_down = -0.432842f;
+    // Depth camera rows and columns share the focal length of the horizontal field of view
+    float fov_horizontal = 1.0123f;
+    double max_range = 50.0;
+    // Uniform range noise, reproducible from the scan seed
+    double range_noise = 0.01;
+};
+
+// Organized x, y, z float32 cloud of the scene seen from T_world_sensor. Rays without a return
+// are NaN, as real sensors report them.
+void RenderScan(const SyntheticScene& scene,
+                const SyntheticSensor& sensor,
+                const Sophus::SE3d& T_world_sensor,
+                const ros::Time& stamp,
+                uint32_t seed,
+                sensor_msgs::PointCloud2& pcd);
+
+// Sensor pose t seconds into a drive down the corridor at the given speed, with a slow sway
+Sophus::SE3d CorridorPose(const SyntheticScene& scene, double t, double speed);
+}  // namespace vdbfusion
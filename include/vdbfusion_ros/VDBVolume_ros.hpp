@@ -22,42 +22,69 @@
 
 #pragma once
 
+#include <ros/callback_queue.h>
+#include <nav_msgs/Path.h>
 #include <ros/ros.h>
 #include <sensor_msgs/PointCloud2.h>
+#include <std_msgs/Empty.h>
 
+#include <memory>
+#include <vector>
+
+#include "Mapper.hpp"
 #include "Transform.hpp"
-#include "vdbfusion/VDBVolume.h"
+#include "vdbfusion_ros/PipelineMetrics.h"
+#include "vdbfusion_ros/VolumeDelta.h"
 #include "vdbfusion_ros/save_vdb_volume.h"
 
 namespace vdbfusion {
+// ROS front end of the Mapper: parameters, topics, services, timers and pose lookups
 class VDBVolumeNode {
 public:
     VDBVolumeNode();
+    ~VDBVolumeNode();
 
 private:
-    VDBVolume InitVDBVolume();
     void Integrate(const sensor_msgs::PointCloud2& pcd);
+    void CorrectPoses(const nav_msgs::Path& path);
+    void EvictTransients(const ros::TimerEvent& event);
+    void PublishDelta(const ros::TimerEvent& event);
+    void Resync(const std_msgs::Empty& request);
+    void PublishMetrics(const ros::TimerEvent& event);
     bool saveVDBVolume(vdbfusion_ros::save_vdb_volume::Request& path,
                        vdbfusion_ros::save_vdb_volume::Response& response);
 
 private:
+    // Scans, poses and services/queries are served from their own queues and spinner threads, so
+    // that saving the map does not stall integration and scans do not delay the services
+    ros::CallbackQueue scan_queue_;
+    ros::CallbackQueue pose_queue_;
+    ros::CallbackQueue service_queue_;
     ros::NodeHandle nh_;
+    ros::NodeHandle scan_nh_;
+    ros::NodeHandle pose_nh_;
+    ros::NodeHandle service_nh_;
+    std::vector<std::unique_ptr<ros::AsyncSpinner>> spinners_;
     ros::Subscriber sub_;
     ros::ServiceServer srv_;
     Transform tf_;
     ros::Duration timestamp_tolerance_;
 
 private:
-    VDBVolume vdb_volume_;
+    Mapper mapper_;
+    ros::Subscriber correction_sub_;
+    ros::Timer eviction_timer_;
 
-    // PointCloud Processing
-    bool preprocess_;
-    bool apply_pose_;
-    float min_range_;
-    float max_range_;
+    // Leaf Streaming
+    ros::Publisher delta_pub_;
+    ros::Subscriber resync_sub_;
+    ros::Timer stream_timer_;
+    LeafDelta delta_;
+    vdbfusion_ros::VolumeDelta delta_msg_;
+    size_t stream_budget_bytes_ = 0;
 
-    // Triangle Mesh Extraction
-    bool fill_holes_;
-    float min_weight_;
+    // Pipeline Metrics
+    ros::Publisher metrics_pub_;
+    ros::Timer metrics_timer_;
 };
 }  // namespace vdbfusion
@@ -0,0 +1,58 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <cstddef>
+
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// How far the map of one integration path is from a reference map of the same scans, e.g.
+// projective against raycast integration
+struct VolumeComparison {
+    // Active tsdf voxels of both volumes, of the result only and of the reference only
+    size_t common_voxels = 0;
+    size_t only_in_result = 0;
+    size_t only_in_reference = 0;
+    // common / union of the two voxel sets, 1 for identical sets
+    double jaccard = 0.0;
+    // RMS of the tsdf difference over the common voxels, in meters
+    double tsdf_rms = 0.0;
+    // Symmetric Chamfer distance of the meshes: every vertex of one mesh is measured against the
+    // surface of the other volume, read from its tsdf. Vertices without any surface of the other
+    // volume within sdf_trunc are counted apart and left out of the distances.
+    double chamfer_mean = 0.0;
+    double chamfer_p95 = 0.0;
+    size_t vertices = 0;
+    size_t unmatched_vertices = 0;
+};
+
+// Both volumes must share the voxel size and the truncation distance. The meshes are extracted
+// with fill_holes and min_weight, as they would be saved.
+VolumeComparison CompareVolumes(const VDBVolume& result,
+                                const VDBVolume& reference,
+                                bool fill_holes,
+                                float min_weight);
+}  // namespace vdbfusion
@@ -0,0 +1,58 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <optional>
+#include <string>
+
+#include "sophus/se3.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// Writes <prefix>_grid.vdb with the tsdf and weights grids, and <prefix>_mesh.ply with the
+// marching cubes mesh of the volume
+void SaveVDBVolume(const VDBVolume& volume,
+                   const std::string& prefix,
+                   bool fill_holes,
+                   float min_weight);
+
+// Reads back a grid file written by SaveVDBVolume. The voxel size and the truncation distance
+// are recovered from the transform and the background of the tsdf grid. Older files only hold
+// the tsdf grid, their active voxels are given a unit weight.
+std::optional<VDBVolume> LoadVDBVolume(const std::string& filename);
+
+// Adds the observations of source to target. Every voxel is a weighted running average, so the
+// merge of two volumes built from disjoint sets of rays equals the volume built from all of them,
+// up to the float rounding of the summation order.
+//
+// T_target_source maps the world frame of source into the one of target, e.g. to align sessions
+// recorded on different days. Unless it is the identity, every target voxel is trilinearly
+// resampled from the active source voxels around it, each one weighted by its own weight, so the
+// inactive background never leaks into the band. The leaves of target are merged in parallel and
+// the cost is proportional to the number of active source leaves. Returns false if the voxel
+// sizes differ.
+bool MergeVolume(VDBVolume& target,
+                 const VDBVolume& source,
+                 const Sophus::SE3d& T_target_source = Sophus::SE3d());
+}  // namespace vdbfusion
@@ -0,0 +1,106 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "FusedVolume.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// Copy of one leaf of the tsdf and of the weights grid
+struct SnapshotLeaf {
+    using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+    LeafT tsdf;
+    LeafT weights;
+};
+
+// Immutable view of the volume at a given version. Leaves that did not change between two
+// snapshots are shared by both, so a reader can hold on to a snapshot for as long as it needs
+// without copying the map and without ever synchronizing with the writer.
+class VolumeSnapshot {
+public:
+    uint64_t version() const { return version_; }
+    size_t size() const { return leaves_.size(); }
+
+    // nullptr if the snapshot has no leaf at this origin
+    const SnapshotLeaf* FindLeaf(const openvdb::Coord& origin) const;
+
+    // Rebuilds the grids, e.g. for meshing or saving, on the reader's thread
+    VDBVolume ToVDBVolume() const;
+
+private:
+    friend class SnapshotWriter;
+
+    uint64_t version_ = 0;
+    float voxel_size_ = 0.0f;
+    float sdf_trunc_ = 0.0f;
+    // Sorted by origin
+    std::vector<openvdb::Coord> origins_;
+    std::vector<std::shared_ptr<const SnapshotLeaf>> leaves_;
+};
+
+// Writer side: takes snapshots of the live volume. The writers of the volume report the leaves
+// they touch through MarkDirty, the next snapshot copies those and shares every other leaf with
+// the previous snapshot by pointer, so taking it costs the copy of the dirty leaves and not a pass
+// over the voxels of the map. It must run where nothing integrates into the volume, the snapshots
+// it returns can then be read from any thread.
+//
+// The previous snapshot is only shared while a reader still holds it, otherwise the next one
+// copies the whole map. With retain the writer holds on to the latest snapshot itself, which
+// keeps a second copy of every leaf of the map resident so that no snapshot has to copy it all.
+class SnapshotWriter {
+public:
+    explicit SnapshotWriter(bool retain = false) : retain_(retain) {}
+
+    // Leaves written, created or removed since the previous snapshot, in any order. Nothing is
+    // recorded while there is no previous snapshot to share leaves with.
+    void MarkDirty(const std::vector<openvdb::Coord>& origins);
+
+    std::shared_ptr<const VolumeSnapshot> Take(const VDBVolume& volume);
+    std::shared_ptr<const VolumeSnapshot> Take(const FusedVolumeBase& volume);
+
+private:
+    // list_leaves(origins) appends the origin of every leaf of the volume, copy_leaf(leaf) fills
+    // a leaf that holds the background values and returns false if it has no voxel
+    template <typename ListLeaves, typename CopyLeaf>
+    std::shared_ptr<const VolumeSnapshot> Take(float voxel_size,
+                                               float sdf_trunc,
+                                               const ListLeaves& list_leaves,
+                                               const CopyLeaf& copy_leaf);
+
+    bool retain_;
+    uint64_t version_ = 0;
+    std::weak_ptr<const VolumeSnapshot> last_;
+    // Only set with retain
+    std::shared_ptr<const VolumeSnapshot> retained_;
+    // Unsorted and with duplicates, compacted whenever it doubled
+    std::vector<openvdb::Coord> dirty_;
+    size_t compacted_ = 0;
+};
+}  // namespace vdbfusion
@@ -0,0 +1,119 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <vector>
+
+#include "vdbfusion/VDBVolume.h"
+
+namespace vdbfusion {
+
+// Leaves of the TSDF volume that changed since the previous delta, the fields of the VolumeDelta
+// message without its header. MapperMsgs converts between the two.
+struct LeafDelta {
+    uint64_t version = 0;
+    bool full = false;
+    float voxel_size = 0.0f;
+    float sdf_trunc = 0.0f;
+    // (x, y, z) index triplets
+    std::vector<int32_t> removed_origins;
+    std::vector<int32_t> leaf_origins;
+    std::vector<uint32_t> leaf_bytes;
+    std::vector<uint8_t> data;
+};
+
+// Publisher side of the leaf streaming. The leaves to send are the ones the writers report as
+// touched (see TouchedLeaves), so encoding never walks the map. Only Collect reads the volume and
+// has to hold the lock its writers take, compressing the collected leaves does not.
+class LeafDeltaEncoder {
+public:
+    // Leaves written since they were last collected. Safe to call while Encode runs.
+    void MarkDirty(const std::vector<openvdb::Coord>& origins);
+
+    // Copies the dirty leaves out of the volume and notes the dirty ones that are gone. After a
+    // Reset every leaf of the volume is copied once. Every Collect is followed by an Encode.
+    void Collect(const VDBVolume& volume, const Eigen::Vector3d& position);
+
+    // Fills delta with the collected leaves, sorted by distance to the collect position, and the
+    // removed ones. Once budget_bytes of records are reached the remaining leaves stay dirty for
+    // the next delta, at least one leaf is always sent. A budget of 0 sends every collected leaf.
+    // Empty deltas keep the version of the previous one and need not be published.
+    void Encode(size_t budget_bytes, LeafDelta& delta);
+
+    // Forgets what was sent, the next deltas resend the whole volume. The first of them is marked
+    // full and is published even if the volume is empty, so the receiver also drops the leaves
+    // whose removal it missed.
+    void Reset();
+
+private:
+    struct DirtyLeaf {
+        openvdb::Coord origin;
+        double distance2;
+        // Offset of its record in records_
+        size_t record;
+    };
+
+    uint64_t version_ = 0;
+    bool full_ = false;
+    float voxel_size_ = 0.0f;
+    float sdf_trunc_ = 0.0f;
+    // Leaves the receiver holds, sorted by origin
+    std::vector<openvdb::Coord> sent_;
+    // Reported by the writers since the last Collect, unsorted and with duplicates
+    std::mutex pending_mutex_;
+    std::vector<openvdb::Coord> pending_;
+    // Collected, reused between deltas
+    std::vector<openvdb::Coord> collected_;
+    std::vector<DirtyLeaf> dirty_;
+    std::vector<openvdb::Coord> removed_;
+    std::vector<char> records_;
+    std::vector<char> compressed_;
+    std::vector<openvdb::Coord> updated_;
+};
+
+// Receiver side: a mirror of the published volume, built from the deltas
+class VolumeMirror {
+public:
+    // Returns false if deltas were missed or the delta is corrupt, a resync request then makes the
+    // publisher resend the whole volume. After a gap the delta is applied anyway, a corrupt one is
+    // dropped without touching the mirror. A full delta replaces whatever the mirror held.
+    bool Apply(const LeafDelta& delta);
+
+    uint64_t version() const { return version_; }
+    // Empty until the first delta arrives
+    const std::optional<VDBVolume>& volume() const { return volume_; }
+
+private:
+    uint64_t version_ = 0;
+    std::optional<VDBVolume> volume_;
+    // Decompressed records of the delta being applied
+    std::vector<char> records_;
+};
+}  // namespace vdbfusion
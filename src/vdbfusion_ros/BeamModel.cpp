@@ -0,0 +1,221 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "BeamModel.hpp"
+
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <cmath>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <vector>
+
+#include "sophus/se3.hpp"
+
+bool vdbfusion::BeamModel::Load(const std::string& filename) {
+    std::ifstream file(filename);
+    size_t n_beams = 0;
+    if (!(file >> n_beams)) {
+        return false;
+    }
+    std::vector<Eigen::Vector3d> directions(n_beams);
+    for (auto& direction : directions) {
+        if (!(file >> direction.x() >> direction.y() >> direction.z())) {
+            return false;
+        }
+    }
+    directions_ = std::move(directions);
+    learned_scans_ = learning_scans_;
+    cached_voxel_size_ = 0.0;
+    return true;
+}
+
+bool vdbfusion::BeamModel::Save(const std::string& filename) const {
+    std::ofstream file(filename);
+    file.precision(std::numeric_limits<double>::max_digits10);
+    file << directions_.size() << "\n";
+    for (const auto& direction : directions_) {
+        file << direction.x() << " " << direction.y() << " " << direction.z() << "\n";
+    }
+    return file.good();
+}
+
+bool vdbfusion::BeamModel::Learn(const ScanBuffer& organized_scan) {
+    if (Ready() && directions_.size() == organized_scan.size()) {
+        return true;
+    }
+    if (directions_.size() != organized_scan.size()) {
+        directions_.assign(organized_scan.size(), Eigen::Vector3d::Zero());
+        learned_scans_ = 0;
+    }
+    for (size_t beam = 0; beam < organized_scan.size(); ++beam) {
+        const Eigen::Vector3f point(organized_scan.x[beam], organized_scan.y[beam],
+                                    organized_scan.z[beam]);
+        if (point.allFinite() && !point.isZero()) {
+            directions_[beam] += point.cast<double>().normalized();
+        }
+    }
+    if (++learned_scans_ < learning_scans_) {
+        return false;
+    }
+    // Beams that never returned stay zero and are skipped while decoding
+    for (auto& direction : directions_) {
+        if (!direction.isZero()) {
+            direction.normalize();
+        }
+    }
+    cached_voxel_size_ = 0.0;
+    return true;
+}
+
+bool vdbfusion::BeamModel::Decode(const ScanBuffer& organized_scan, BeamScan& scan) const {
+    scan.beams.clear();
+    scan.ranges.clear();
+    if (!Ready() || organized_scan.size() != directions_.size() ||
+        organized_scan.keep.size() != organized_scan.size()) {
+        return false;
+    }
+    for (size_t beam = 0; beam < organized_scan.size(); ++beam) {
+        if (!organized_scan.keep[beam] || directions_[beam].isZero()) {
+            continue;
+        }
+        const Eigen::Vector3d point(organized_scan.x[beam], organized_scan.y[beam],
+                                    organized_scan.z[beam]);
+        const double range = point.norm();
+        if (range == 0.0) {
+            continue;
+        }
+        // The point is integrated along the learned direction, which must still be its own
+        if (point.dot(directions_[beam]) < min_cos_error_ * range) {
+            scan.beams.clear();
+            scan.ranges.clear();
+            return false;
+        }
+        scan.beams.emplace_back(static_cast<uint32_t>(beam));
+        scan.ranges.emplace_back(static_cast<float>(range));
+    }
+    return true;
+}
+
+const std::vector<vdbfusion::BeamModel::Ray>& vdbfusion::BeamModel::Orient(
+    const Eigen::Matrix3d& R_world_sensor, double voxel_size, const std::vector<uint32_t>& beams) {
+    if (rays_.size() != directions_.size()) {
+        rays_.resize(directions_.size());
+        ray_generation_.assign(directions_.size(), 0);
+        cached_voxel_size_ = 0.0;
+    }
+    if (R_world_sensor != cached_rotation_ || voxel_size != cached_voxel_size_) {
+        ++generation_;
+        cached_rotation_ = R_world_sensor;
+        cached_voxel_size_ = voxel_size;
+    }
+    constexpr double inf = std::numeric_limits<double>::infinity();
+    for (const uint32_t beam : beams) {
+        if (ray_generation_[beam] == generation_) {
+            continue;
+        }
+        auto& ray = rays_[beam];
+        ray.direction = R_world_sensor * directions_[beam];
+        for (int axis = 0; axis < 3; ++axis) {
+            const double d = ray.direction[axis];
+            ray.step[axis] = d > 0.0 ? 1 : (d < 0.0 ? -1 : 0);
+            ray.inv_direction[axis] = d != 0.0 ? 1.0 / d : inf;
+            ray.t_delta[axis] = d != 0.0 ? voxel_size * std::abs(ray.inv_direction[axis]) : inf;
+        }
+        ray_generation_[beam] = generation_;
+    }
+    return rays_;
+}
+
+void vdbfusion::IntegrateBeams(VDBVolume& volume,
+                               BeamModel& beam_model,
+                               const BeamScan& scan,
+                               const Sophus::SE3d& T_world_sensor,
+                               const std::function<float(float)>& weighting_function,
+                               TouchedLeaves& touched) {
+    using LeafT = openvdb::FloatTree::LeafNodeType;
+    if (scan.beams.empty()) {
+        return;
+    }
+    const openvdb::Int32 leaf_mask = ~static_cast<openvdb::Int32>(LeafT::DIM - 1);
+    const openvdb::math::Transform& xform = volume.tsdf_->transform();
+    const double voxel_size = xform.voxelSize()[0];
+    const float sdf_trunc = volume.sdf_trunc_;
+    const auto& rays = beam_model.Orient(T_world_sensor.rotationMatrix(), voxel_size, scan.beams);
+    const Eigen::Vector3d origin = T_world_sensor.translation();
+    const openvdb::Vec3d eye_index =
+        xform.worldToIndex(openvdb::Vec3d(origin.x(), origin.y(), origin.z()));
+    const Eigen::Vector3d eye(eye_index.x(), eye_index.y(), eye_index.z());
+    constexpr double inf = std::numeric_limits<double>::infinity();
+
+    auto tsdf_acc = volume.tsdf_->getUnsafeAccessor();
+    auto weights_acc = volume.weights_->getUnsafeAccessor();
+    for (size_t i = 0; i < scan.beams.size(); ++i) {
+        const auto& ray = rays[scan.beams[i]];
+        const double depth = scan.ranges[i];
+        const Eigen::Vector3d point = origin + depth * ray.direction;
+        const double t0 = volume.space_carving_ ? 0.0 : depth - sdf_trunc;
+        const double t1 = depth + sdf_trunc;
+
+        // Amanatides & Woo traversal in index space, t is kept in world units
+        const Eigen::Vector3d start = eye + (t0 / voxel_size) * ray.direction;
+        openvdb::Coord voxel(static_cast<openvdb::Int32>(std::floor(start.x())),
+                             static_cast<openvdb::Int32>(std::floor(start.y())),
+                             static_cast<openvdb::Int32>(std::floor(start.z())));
+        Eigen::Vector3d t_max;
+        for (int axis = 0; axis < 3; ++axis) {
+            const double boundary = voxel[axis] + (ray.step[axis] > 0 ? 1 : 0);
+            t_max[axis] = ray.step[axis] != 0
+                              ? t0 + (boundary - start[axis]) * voxel_size * ray.inv_direction[axis]
+                              : inf;
+        }
+        while (true) {
+            const openvdb::Vec3d c = xform.indexToWorld(voxel) + voxel_size / 2.0;
+            const Eigen::Vector3d voxel_center(c.x(), c.y(), c.z());
+            const Eigen::Vector3d v_voxel_origin = voxel_center - origin;
+            const Eigen::Vector3d v_point_voxel = point - voxel_center;
+            const auto sdf = static_cast<float>(
+                std::copysign(v_point_voxel.norm(), v_voxel_origin.dot(v_point_voxel)));
+            if (sdf > -sdf_trunc) {
+                const float tsdf = std::min(sdf_trunc, sdf);
+                const float weight = weighting_function(sdf);
+                const float last_weight = weights_acc.getValue(voxel);
+                const float last_tsdf = tsdf_acc.getValue(voxel);
+                const float new_weight = weight + last_weight;
+                const float new_tsdf = (last_tsdf * last_weight + tsdf * weight) / (new_weight);
+                tsdf_acc.setValue(voxel, new_tsdf);
+                weights_acc.setValue(voxel, new_weight);
+                touched.Add(voxel & leaf_mask);
+            }
+
+            int axis = t_max.x() < t_max.y() ? 0 : 1;
+            axis = t_max[axis] < t_max.z() ? axis : 2;
+            if (t_max[axis] > t1) {
+                break;
+            }
+            voxel[axis] += ray.step[axis];
+            t_max[axis] += ray.t_delta[axis];
+        }
+    }
+}
@@ -0,0 +1,150 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Decode.hpp"
+
+#include <ros/ros.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/PointField.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "ScanBuffer.hpp"
+
+namespace {
+const sensor_msgs::PointField* FindField(const sensor_msgs::PointCloud2& pcl2,
+                                         const char* name,
+                                         uint8_t datatype) {
+    for (const auto& field : pcl2.fields) {
+        if (field.name == name && field.datatype == datatype) {
+            return &field;
+        }
+    }
+    return nullptr;
+}
+
+bool HostIsBigEndian() {
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    return first == 0;
+}
+
+// Reads a field of the point, reversing its bytes if the cloud's byte order is not the host's
+template <typename T>
+T Load(const uint8_t* point, uint32_t offset, bool swap) {
+    uint8_t bytes[sizeof(T)];
+    std::memcpy(bytes, point + offset, sizeof(T));
+    if (swap) {
+        std::reverse(bytes, bytes + sizeof(T));
+    }
+    T value;
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+// A missing field fits trivially
+bool FieldFits(const sensor_msgs::PointField* field, size_t bytes, uint32_t point_step) {
+    return field == nullptr || static_cast<uint64_t>(field->offset) + bytes <= point_step;
+}
+
+// Every point of every row has to lie inside data
+const char* CheckRows(const sensor_msgs::PointCloud2& pcl2) {
+    if (static_cast<uint64_t>(pcl2.width) * pcl2.point_step > pcl2.row_step) {
+        return "row_step is smaller than width * point_step";
+    }
+    if (static_cast<uint64_t>(pcl2.height) * pcl2.row_step > pcl2.data.size()) {
+        return "data is smaller than height * row_step";
+    }
+    return nullptr;
+}
+}  // namespace
+
+size_t vdbfusion::pcl2SensorMsgToScanBuffer(const sensor_msgs::PointCloud2& pcl2,
+                                            ScanBuffer& scan,
+                                            bool keep_layout) {
+    using sensor_msgs::PointField;
+    const auto* x = FindField(pcl2, "x", PointField::FLOAT32);
+    const auto* y = FindField(pcl2, "y", PointField::FLOAT32);
+    const auto* z = FindField(pcl2, "z", PointField::FLOAT32);
+    if (x == nullptr || y == nullptr || z == nullptr) {
+        ROS_WARN_THROTTLE(30, "PointCloud2 without float32 x, y, z fields");
+        scan.clear();
+        return 0;
+    }
+    const auto* intensity = FindField(pcl2, "intensity", PointField::FLOAT32);
+    const auto* time = FindField(pcl2, "time", PointField::FLOAT32);
+    const auto* ring = FindField(pcl2, "ring", PointField::UINT16);
+    const uint32_t step = pcl2.point_step;
+    const char* malformed = CheckRows(pcl2);
+    if (malformed == nullptr &&
+        !(FieldFits(x, sizeof(float), step) && FieldFits(y, sizeof(float), step) &&
+          FieldFits(z, sizeof(float), step) && FieldFits(intensity, sizeof(float), step) &&
+          FieldFits(time, sizeof(float), step) && FieldFits(ring, sizeof(uint16_t), step))) {
+        malformed = "a field does not fit into point_step";
+    }
+    if (malformed != nullptr) {
+        ROS_WARN_THROTTLE(30, "Dropping malformed PointCloud2: %s", malformed);
+        scan.clear();
+        return 0;
+    }
+    const bool swap = static_cast<bool>(pcl2.is_bigendian) != HostIsBigEndian();
+    scan.resize(static_cast<size_t>(pcl2.width) * pcl2.height, intensity != nullptr,
+                time != nullptr, ring != nullptr);
+
+    // Dense clouds promise finite points, everything else is checked point by point. The write
+    // index only advances over valid points, invalid ones get overwritten by the next point.
+    const bool check = !pcl2.is_dense;
+    const size_t skip = check && !keep_layout ? 1 : 0;
+    size_t i = 0;
+    size_t n_invalid = 0;
+    for (uint32_t row = 0; row < pcl2.height; ++row) {
+        const uint8_t* point = pcl2.data.data() + static_cast<size_t>(row) * pcl2.row_step;
+        for (uint32_t col = 0; col < pcl2.width; ++col, point += pcl2.point_step) {
+            const float px = Load<float>(point, x->offset, swap);
+            const float py = Load<float>(point, y->offset, swap);
+            const float pz = Load<float>(point, z->offset, swap);
+            scan.x[i] = px;
+            scan.y[i] = py;
+            scan.z[i] = pz;
+            if (intensity != nullptr) {
+                scan.intensity[i] = Load<float>(point, intensity->offset, swap);
+            }
+            if (time != nullptr) {
+                scan.time[i] = Load<float>(point, time->offset, swap);
+            }
+            if (ring != nullptr) {
+                scan.ring[i] = Load<uint16_t>(point, ring->offset, swap);
+            }
+            // NaN and inf fail the x - x == 0 test, zero range is the usual "no return" marker
+            const size_t invalid =
+                check & !(((px - px) == 0.0f) & ((py - py) == 0.0f) & ((pz - pz) == 0.0f) &
+                          ((px != 0.0f) | (py != 0.0f) | (pz != 0.0f)));
+            n_invalid += invalid;
+            i += 1 - (invalid & skip);
+        }
+    }
+    scan.resize(i, intensity != nullptr, time != nullptr, ring != nullptr);
+    return n_invalid;
+}
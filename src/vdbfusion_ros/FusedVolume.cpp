@@ -0,0 +1,218 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "FusedVolume.hpp"
+
+#include <openvdb/math/DDA.h>
+#include <openvdb/math/Ray.h>
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace {
+// Voxel centers and signed distances are computed exactly like vdbfusion's VDBVolume does, down
+// to the single precision voxel size and the sign taken from the projection
+Eigen::Vector3d VoxelCenter(const openvdb::Coord& voxel, const openvdb::math::Transform& xform) {
+    const float voxel_size = xform.voxelSize()[0];
+    const openvdb::Vec3d c = xform.indexToWorld(voxel) + voxel_size / 2.0;
+    return Eigen::Vector3d(c.x(), c.y(), c.z());
+}
+
+float SignedDistance(const Eigen::Vector3d& origin,
+                     const Eigen::Vector3d& point,
+                     const Eigen::Vector3d& voxel_center) {
+    const Eigen::Vector3d v_voxel_origin = voxel_center - origin;
+    const Eigen::Vector3d v_point_voxel = point - voxel_center;
+    const double dist = v_point_voxel.norm();
+    const double proj = v_voxel_origin.dot(v_point_voxel);
+    const double sign = proj / std::abs(proj);
+    return static_cast<float>(sign * dist);
+}
+
+// vdbfusion's constant weighting, inlined into the update loop
+struct UnitWeight {
+    float operator()(float /*sdf*/) const { return 1.0f; }
+};
+}  // namespace
+
+template <openvdb::Index Log2Dim>
+vdbfusion::FusedVolume<Log2Dim>::FusedVolume(float voxel_size, float sdf_trunc, bool space_carving)
+    : FusedVolumeBase(voxel_size, sdf_trunc, space_carving) {
+    grid_ = GridT::create(openvdb::Vec2f(sdf_trunc_, 0.0f));
+    grid_->setName("D(x), W(x): fused signed distance and weights grid");
+    grid_->setTransform(openvdb::math::Transform::createLinearTransform(voxel_size_));
+}
+
+template <openvdb::Index Log2Dim>
+void vdbfusion::FusedVolume<Log2Dim>::Integrate(
+    const std::vector<Eigen::Vector3d>& points,
+    const Eigen::Vector3d& origin,
+    const std::function<float(float)>& weighting_function) {
+    auto acc = grid_->getUnsafeAccessor();
+    IntegrateScan(acc, points, origin, weighting_function);
+}
+
+template <openvdb::Index Log2Dim>
+void vdbfusion::FusedVolume<Log2Dim>::Integrate(
+    const ScanBatch& batch, const std::function<float(float)>& weighting_function) {
+    auto acc = grid_->getUnsafeAccessor();
+    for (size_t scan = 0; scan < batch.size(); ++scan) {
+        IntegrateScan(acc, batch.points[scan], batch.origins[scan], weighting_function);
+    }
+}
+
+template <openvdb::Index Log2Dim>
+void vdbfusion::FusedVolume<Log2Dim>::Integrate(const ScanBatch& batch) {
+    auto acc = grid_->getUnsafeAccessor();
+    for (size_t scan = 0; scan < batch.size(); ++scan) {
+        IntegrateScan(acc, batch.points[scan], batch.origins[scan], UnitWeight());
+    }
+}
+
+template <openvdb::Index Log2Dim>
+template <typename Weighting>
+void vdbfusion::FusedVolume<Log2Dim>::IntegrateScan(typename GridT::UnsafeAccessor& acc,
+                                                    const std::vector<Eigen::Vector3d>& points,
+                                                    const Eigen::Vector3d& origin,
+                                                    const Weighting& weighting_function) {
+    const openvdb::math::Transform& xform = grid_->transform();
+    const openvdb::Vec3R eye(origin.x(), origin.y(), origin.z());
+
+    for (const auto& point : points) {
+        const Eigen::Vector3d direction = point - origin;
+        openvdb::Vec3R dir(direction.x(), direction.y(), direction.z());
+        dir.normalize();
+        // Single precision ray and DDA like vdbfusion, so both layouts visit the same voxels
+        const auto depth = static_cast<float>(direction.norm());
+        const float t0 = space_carving_ ? 0.0f : depth - sdf_trunc_;
+        const float t1 = depth + sdf_trunc_;
+        const auto ray = openvdb::math::Ray<float>(eye, dir, t0, t1).worldToIndex(*grid_);
+        openvdb::math::DDA<decltype(ray)> dda(ray);
+        do {
+            const auto voxel = dda.voxel();
+            const auto sdf = SignedDistance(origin, point, VoxelCenter(voxel, xform));
+            if (sdf > -sdf_trunc_) {
+                const float tsdf = std::min(sdf_trunc_, sdf);
+                const float weight = weighting_function(sdf);
+                const openvdb::Vec2f last = acc.getValue(voxel);
+                const float new_weight = weight + last[1];
+                const float new_tsdf = (last[0] * last[1] + tsdf * weight) / new_weight;
+                acc.setValue(voxel, openvdb::Vec2f(new_tsdf, new_weight));
+            }
+        } while (dda.step());
+    }
+}
+
+template <openvdb::Index Log2Dim>
+vdbfusion::VDBVolume vdbfusion::FusedVolume<Log2Dim>::Split() const {
+    VDBVolume volume(voxel_size_, sdf_trunc_, space_carving_);
+    auto& tsdf_tree = volume.tsdf_->tree();
+    auto& weights_tree = volume.weights_->tree();
+    for (auto leaf = grid_->tree().cbeginLeaf(); leaf; ++leaf) {
+        if constexpr (Log2Dim == 3) {
+            // Same leaf layout as the float grids, copy by offset
+            auto* tsdf_leaf = tsdf_tree.touchLeaf(leaf->origin());
+            auto* weights_leaf = weights_tree.touchLeaf(leaf->origin());
+            for (auto value = leaf->cbeginValueOn(); value; ++value) {
+                tsdf_leaf->setValueOn(value.pos(), (*value)[0]);
+                weights_leaf->setValueOn(value.pos(), (*value)[1]);
+            }
+            continue;
+        }
+        for (auto value = leaf->cbeginValueOn(); value; ++value) {
+            const openvdb::Coord voxel = value.getCoord();
+            tsdf_tree.setValueOn(voxel, (*value)[0]);
+            weights_tree.setValueOn(voxel, (*value)[1]);
+        }
+    }
+    return volume;
+}
+
+template <openvdb::Index Log2Dim>
+bool vdbfusion::FusedVolume<Log2Dim>::CopyLeaf(FloatLeafT& tsdf, FloatLeafT& weights) const {
+    bool active = false;
+    if constexpr (Log2Dim == 3) {
+        const auto* leaf = grid_->tree().probeConstLeaf(tsdf.origin());
+        if (leaf == nullptr) {
+            return false;
+        }
+        for (auto value = leaf->cbeginValueOn(); value; ++value) {
+            tsdf.setValueOn(value.pos(), (*value)[0]);
+            weights.setValueOn(value.pos(), (*value)[1]);
+            active = true;
+        }
+        return active;
+    }
+    // The fused leaves do not line up with the float ones, go voxel by voxel
+    auto acc = grid_->getConstAccessor();
+    openvdb::Vec2f value;
+    for (openvdb::Index offset = 0; offset < FloatLeafT::SIZE; ++offset) {
+        if (acc.probeValue(tsdf.offsetToGlobalCoord(offset), value)) {
+            tsdf.setValueOn(offset, value[0]);
+            weights.setValueOn(offset, value[1]);
+            active = true;
+        }
+    }
+    return active;
+}
+
+template <openvdb::Index Log2Dim>
+void vdbfusion::FusedVolume<Log2Dim>::LeafOrigins(std::vector<openvdb::Coord>& origins) const {
+    constexpr openvdb::Int32 kDim = 1 << Log2Dim;
+    constexpr openvdb::Int32 kFloatDim = FloatLeafT::DIM;
+    for (auto leaf = grid_->tree().cbeginLeaf(); leaf; ++leaf) {
+        const openvdb::Coord origin = leaf->origin() & ~(kFloatDim - 1);
+        // A larger leaf spans several float leaves
+        for (openvdb::Int32 x = 0; x < kDim; x += kFloatDim) {
+            for (openvdb::Int32 y = 0; y < kDim; y += kFloatDim) {
+                for (openvdb::Int32 z = 0; z < kDim; z += kFloatDim) {
+                    origins.push_back(origin.offsetBy(x, y, z));
+                }
+            }
+        }
+    }
+}
+
+template class vdbfusion::FusedVolume<2>;
+template class vdbfusion::FusedVolume<3>;
+template class vdbfusion::FusedVolume<4>;
+
+std::unique_ptr<vdbfusion::FusedVolumeBase> vdbfusion::MakeFusedVolume(int leaf_dim,
+                                                                       float voxel_size,
+                                                                       float sdf_trunc,
+                                                                       bool space_carving) {
+    switch (leaf_dim) {
+        case 4:
+            return std::make_unique<FusedVolume<2>>(voxel_size, sdf_trunc, space_carving);
+        case 8:
+            return std::make_unique<FusedVolume<3>>(voxel_size, sdf_trunc, space_carving);
+        case 16:
+            return std::make_unique<FusedVolume<4>>(voxel_size, sdf_trunc, space_carving);
+        default:
+            return nullptr;
+    }
+}
@@ -0,0 +1,207 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "HardwareCounters.hpp"
+
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#include <tbb/task_scheduler_observer.h>
+#include <unistd.h>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <mutex>
+#include <vector>
+
+namespace {
+struct EventSpec {
+    uint32_t type;
+    uint64_t config;
+};
+
+constexpr uint64_t ReadMisses(uint64_t cache) {
+    return cache | (uint64_t(PERF_COUNT_HW_CACHE_OP_READ) << 8) |
+           (uint64_t(PERF_COUNT_HW_CACHE_RESULT_MISS) << 16);
+}
+
+// In the order of vdbfusion::Counter, cycles lead the group
+constexpr EventSpec kEvents[vdbfusion::kCounterCount] = {
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {PERF_TYPE_HW_CACHE, ReadMisses(PERF_COUNT_HW_CACHE_LL)},
+    {PERF_TYPE_HW_CACHE, ReadMisses(PERF_COUNT_HW_CACHE_DTLB)},
+    {PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES}};
+
+int OpenEvent(const EventSpec& spec, int group_fd) {
+    perf_event_attr attr;
+    std::memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = spec.type;
+    attr.config = spec.config;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    attr.read_format =
+        PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+    // This thread on any CPU
+    return static_cast<int>(
+        syscall(SYS_perf_event_open, &attr, 0, -1, group_fd, PERF_FLAG_FD_CLOEXEC));
+}
+
+struct ThreadGroup {
+    int leader = -1;
+    // Position of every counter in the group read, -1 if it could not be opened
+    std::array<int, vdbfusion::kCounterCount> slot;
+    int size = 0;
+};
+
+ThreadGroup OpenGroup() {
+    ThreadGroup group;
+    group.slot.fill(-1);
+    for (size_t i = 0; i < vdbfusion::kCounterCount; ++i) {
+        const int fd = OpenEvent(kEvents[i], group.leader);
+        if (fd < 0) {
+            if (i == 0) {
+                return group;
+            }
+            continue;
+        }
+        if (i == 0) {
+            group.leader = fd;
+        }
+        group.slot[i] = group.size++;
+    }
+    return group;
+}
+
+// Adds the counts of one thread, scaled up if the group had to share the PMU with other events
+void AddGroup(const ThreadGroup& group, vdbfusion::CounterValues& values) {
+    uint64_t data[3 + vdbfusion::kCounterCount];
+    const ssize_t n_read = read(group.leader, data, sizeof(data));
+    if (n_read < static_cast<ssize_t>(3 * sizeof(uint64_t)) || data[2] == 0) {
+        return;
+    }
+    const double scale = static_cast<double>(data[1]) / static_cast<double>(data[2]);
+    for (size_t i = 0; i < vdbfusion::kCounterCount; ++i) {
+        if (group.slot[i] >= 0 && group.slot[i] < static_cast<int>(data[0])) {
+            const double count = static_cast<double>(data[3 + group.slot[i]]);
+            values[i] += static_cast<uint64_t>(count * scale);
+        }
+    }
+}
+
+// Opens the counters of the TBB workers as they join the scheduler
+class WorkerObserver : public tbb::task_scheduler_observer {
+public:
+    WorkerObserver() { observe(true); }
+    void on_scheduler_entry(bool /*is_worker*/) override {
+        vdbfusion::HardwareCounters::Instance().AttachThread();
+    }
+};
+
+struct Registry {
+    std::atomic<bool> enabled{false};
+    std::mutex mutex;
+    std::vector<ThreadGroup> groups;
+    std::array<bool, vdbfusion::kCounterCount> available{};
+};
+
+Registry registry;
+thread_local bool attached = false;
+}  // namespace
+
+const char* vdbfusion::CounterName(Counter counter) {
+    switch (counter) {
+        case Counter::kCycles:
+            return "cycles";
+        case Counter::kInstructions:
+            return "instructions";
+        case Counter::kLLCMisses:
+            return "llc_misses";
+        case Counter::kDTLBMisses:
+            return "dtlb_misses";
+        case Counter::kBranchMisses:
+            return "branch_misses";
+    }
+    return "unknown";
+}
+
+vdbfusion::HardwareCounters& vdbfusion::HardwareCounters::Instance() {
+    static HardwareCounters instance;
+    return instance;
+}
+
+bool vdbfusion::HardwareCounters::Enable() {
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    if (registry.enabled.load(std::memory_order_relaxed)) {
+        return true;
+    }
+    const ThreadGroup group = OpenGroup();
+    if (group.leader < 0) {
+        return false;
+    }
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        registry.available[i] = group.slot[i] >= 0;
+    }
+    registry.groups.push_back(group);
+    attached = true;
+    registry.enabled.store(true, std::memory_order_release);
+    // Lives as long as the process, like the counters it opens
+    static auto* observer = new WorkerObserver();
+    (void)observer;
+    return true;
+}
+
+bool vdbfusion::HardwareCounters::Enabled() const {
+    return registry.enabled.load(std::memory_order_acquire);
+}
+
+bool vdbfusion::HardwareCounters::Available(Counter counter) const {
+    return Enabled() && registry.available[static_cast<size_t>(counter)];
+}
+
+void vdbfusion::HardwareCounters::AttachThread() {
+    if (attached || !Enabled()) {
+        return;
+    }
+    attached = true;
+    const ThreadGroup group = OpenGroup();
+    if (group.leader < 0) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.groups.push_back(group);
+}
+
+bool vdbfusion::HardwareCounters::Read(CounterValues& values) {
+    values.fill(0);
+    if (!Enabled()) {
+        return false;
+    }
+    AttachThread();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (const auto& group : registry.groups) {
+        AddGroup(group, values);
+    }
+    return true;
+}
@@ -0,0 +1,95 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LeafEviction.hpp"
+
+#include <openvdb/openvdb.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "LeafStamps.hpp"
+
+void vdbfusion::TransientLeafEvictor::Touch(const std::vector<openvdb::Coord>& origins,
+                                            double stamp) {
+    for (const auto& origin : origins) {
+        pending_.push_back({origin, stamp});
+    }
+}
+
+vdbfusion::EvictionStats vdbfusion::TransientLeafEvictor::Evict(VDBVolume& volume,
+                                                                double now,
+                                                                TouchedLeaves& removed) {
+    using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+    auto& tsdf_tree = volume.tsdf_->tree();
+    auto& weights_tree = volume.weights_->tree();
+    EvictionStats stats{0, 0, 0};
+
+    // The updates since the last pass refresh the tracked leaves, the latest one wins
+    const auto by_origin = [](const TrackedLeaf& a, const TrackedLeaf& b) {
+        return a.origin < b.origin;
+    };
+    std::stable_sort(pending_.begin(), pending_.end(), by_origin);
+    merged_.clear();
+    auto tracked = tracked_.cbegin();
+    for (size_t i = 0; i < pending_.size(); ++i) {
+        if (i + 1 < pending_.size() && pending_[i + 1].origin == pending_[i].origin) {
+            continue;
+        }
+        for (; tracked != tracked_.cend() && tracked->origin < pending_[i].origin; ++tracked) {
+            merged_.push_back(*tracked);
+        }
+        if (tracked != tracked_.cend() && tracked->origin == pending_[i].origin) {
+            ++tracked;
+        }
+        merged_.push_back(pending_[i]);
+    }
+    merged_.insert(merged_.end(), tracked, tracked_.cend());
+    pending_.clear();
+
+    // Old leaves with only low weights go, the ones that are too young stay tracked
+    tracked_.clear();
+    for (const auto& leaf : merged_) {
+        if (now - leaf.last_update <= max_age_) {
+            tracked_.push_back(leaf);
+            continue;
+        }
+        const LeafT* weights = weights_tree.probeConstLeaf(leaf.origin);
+        if (weights == nullptr) {
+            continue;
+        }
+        bool transient = true;
+        for (auto value = weights->cbeginValueOn(); value && transient; ++value) {
+            transient = *value < max_weight_;
+        }
+        if (!transient) {
+            continue;
+        }
+        stats.evicted_voxels += weights->onVoxelCount();
+        delete weights_tree.stealNode<LeafT>(leaf.origin, weights_tree.background(), false);
+        delete tsdf_tree.stealNode<LeafT>(leaf.origin, tsdf_tree.background(), false);
+        removed.Add(leaf.origin);
+        ++stats.evicted_leaves;
+    }
+    stats.remaining_leaves = weights_tree.leafCount();
+    return stats;
+}
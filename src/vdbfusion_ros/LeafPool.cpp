@@ -0,0 +1,345 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LeafPool.hpp"
+
+#include <openvdb/openvdb.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+namespace {
+constexpr size_t kSlabSize = size_t(2) << 20;  // One huge page
+constexpr size_t kBatch = 64;                  // Blocks moved between a thread and the pool
+constexpr size_t kAlignment = 16;
+
+constexpr size_t AlignUp(size_t size) { return (size + kAlignment - 1) & ~(kAlignment - 1); }
+
+using LeafT = openvdb::FloatTree::LeafNodeType;
+using FusedLeafT = openvdb::Vec2STree::LeafNodeType;
+constexpr size_t kNumClasses = 3;
+constexpr size_t kBlockSizes[kNumClasses] = {
+    AlignUp(sizeof(LeafT)),                                      // LeafNode
+    AlignUp(LeafT::SIZE * sizeof(LeafT::ValueType)),            // LeafBuffer data
+    AlignUp(FusedLeafT::SIZE * sizeof(FusedLeafT::ValueType)),  // Fused LeafBuffer data
+};
+static_assert(sizeof(FusedLeafT) == sizeof(LeafT), "Fused leaves share the LeafNode size class");
+
+int ClassFor(size_t size) {
+    for (size_t cls = 0; cls < kNumClasses; ++cls) {
+        if (AlignUp(size) == kBlockSizes[cls]) {
+            return static_cast<int>(cls);
+        }
+    }
+    return -1;
+}
+
+struct FreeBlock {
+    FreeBlock* next;
+};
+
+struct SizeClass {
+    std::mutex mutex;
+    FreeBlock* free_list = nullptr;
+    char* bump = nullptr;
+    char* bump_end = nullptr;
+};
+
+struct PoolState {
+    std::atomic<bool> enabled{false};
+    std::atomic<char*> begin{nullptr};
+    std::atomic<char*> end{nullptr};
+    std::atomic<char*> next_slab{nullptr};
+    std::atomic<size_t> slabs{0};
+    std::atomic<size_t> allocations{0};
+    std::atomic<size_t> deallocations{0};
+    std::atomic<int64_t> refill_ns{0};
+    SizeClass classes[kNumClasses];
+    uint8_t* slab_class = nullptr;  // Owning size class of every slab in the region
+};
+PoolState pool;
+
+// Thread local caches keep the common allocate/free path free of locks. The cache itself is
+// trivially destructible so it stays usable while other thread_local objects are destroyed, the
+// flusher hands its blocks back to the shared free lists when the thread exits.
+struct LocalCache {
+    FreeBlock* head[kNumClasses];
+    size_t count[kNumClasses];
+    bool flushed;
+};
+thread_local LocalCache local_cache{};
+
+void ReleaseBlocks(int cls, size_t n_blocks) {
+    auto& cache = local_cache;
+    auto& size_class = pool.classes[cls];
+    std::lock_guard<std::mutex> lock(size_class.mutex);
+    for (size_t i = 0; i < n_blocks && cache.head[cls] != nullptr; ++i) {
+        FreeBlock* block = cache.head[cls];
+        cache.head[cls] = block->next;
+        --cache.count[cls];
+        block->next = size_class.free_list;
+        size_class.free_list = block;
+    }
+}
+
+struct LocalCacheFlusher {
+    ~LocalCacheFlusher() {
+        for (size_t cls = 0; cls < kNumClasses; ++cls) {
+            ReleaseBlocks(static_cast<int>(cls), local_cache.count[cls]);
+        }
+        local_cache.flushed = true;
+    }
+};
+thread_local LocalCacheFlusher local_cache_flusher;
+
+// Depth of the LeafAllocationScopes of the thread
+thread_local int scope_depth = 0;
+
+char* NewSlab(int cls) {
+    char* begin = pool.begin.load(std::memory_order_relaxed);
+    char* end = pool.end.load(std::memory_order_relaxed);
+    // The counter stops at the end of the region once it is exhausted
+    char* slab = pool.next_slab.load(std::memory_order_relaxed);
+    do {
+        if (static_cast<size_t>(end - slab) < kSlabSize) {
+            return nullptr;
+        }
+    } while (!pool.next_slab.compare_exchange_weak(slab, slab + kSlabSize,
+                                                   std::memory_order_relaxed));
+    pool.slab_class[static_cast<size_t>(slab - begin) / kSlabSize] = static_cast<uint8_t>(cls);
+    pool.slabs.fetch_add(1, std::memory_order_relaxed);
+    return slab;
+}
+
+// Pops a block from the shared free list or carves it from the current slab. Called with the
+// size class mutex held.
+FreeBlock* TakeBlock(int cls) {
+    auto& size_class = pool.classes[cls];
+    if (FreeBlock* block = size_class.free_list) {
+        size_class.free_list = block->next;
+        return block;
+    }
+    if (size_class.bump + kBlockSizes[cls] > size_class.bump_end) {
+        char* slab = NewSlab(cls);
+        if (slab == nullptr) {
+            return nullptr;
+        }
+        size_class.bump = slab;
+        size_class.bump_end = slab + kSlabSize;
+    }
+    auto* block = reinterpret_cast<FreeBlock*>(size_class.bump);
+    size_class.bump += kBlockSizes[cls];
+    return block;
+}
+
+void* Refill(int cls) {
+    const auto start = std::chrono::steady_clock::now();
+    auto& cache = local_cache;
+    auto& size_class = pool.classes[cls];
+    FreeBlock* result = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(size_class.mutex);
+        result = TakeBlock(cls);
+        // Threads that already went through their exit path do not cache anything
+        for (size_t i = 1; result != nullptr && !cache.flushed && i < kBatch; ++i) {
+            FreeBlock* block = TakeBlock(cls);
+            if (block == nullptr) {
+                break;
+            }
+            block->next = cache.head[cls];
+            cache.head[cls] = block;
+            ++cache.count[cls];
+        }
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+    pool.refill_ns.fetch_add(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                             std::memory_order_relaxed);
+    return result;
+}
+}  // namespace
+
+vdbfusion::LeafPool& vdbfusion::LeafPool::Instance() {
+    static LeafPool instance;
+    return instance;
+}
+
+bool vdbfusion::LeafPool::Enable(size_t reserve_bytes, bool huge_pages) {
+    if (Enabled()) {
+        return true;
+    }
+    // Reserve address space only, pages are backed on first touch. The extra slab is used to
+    // align the region to a huge page boundary.
+    reserve_bytes = (reserve_bytes + kSlabSize - 1) & ~(kSlabSize - 1);
+    const size_t mapped_bytes = reserve_bytes + kSlabSize;
+    void* mapping = mmap(nullptr, mapped_bytes, PROT_READ | PROT_WRITE,
+                         MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    if (mapping == MAP_FAILED) {
+        return false;
+    }
+    auto* begin = reinterpret_cast<char*>(
+        (reinterpret_cast<uintptr_t>(mapping) + kSlabSize - 1) & ~(uintptr_t(kSlabSize) - 1));
+    if (huge_pages) {
+        madvise(begin, reserve_bytes, MADV_HUGEPAGE);
+    }
+    pool.slab_class = static_cast<uint8_t*>(std::calloc(reserve_bytes / kSlabSize, 1));
+    if (pool.slab_class == nullptr) {
+        munmap(mapping, mapped_bytes);
+        return false;
+    }
+    pool.begin.store(begin, std::memory_order_relaxed);
+    pool.end.store(begin + reserve_bytes, std::memory_order_relaxed);
+    pool.next_slab.store(begin, std::memory_order_relaxed);
+    pool.enabled.store(true, std::memory_order_release);
+
+    // Without the hooks nothing would ever reach the pool
+    bool hooked;
+    {
+        LeafAllocationScope scope;
+        void* probe = ::operator new(kBlockSizes[1]);
+        auto* p = static_cast<char*>(probe);
+        hooked = p >= begin && p < begin + reserve_bytes;
+        ::operator delete(probe);
+    }
+    if (!hooked) {
+        pool.enabled.store(false, std::memory_order_release);
+        pool.begin.store(nullptr, std::memory_order_relaxed);
+        pool.end.store(nullptr, std::memory_order_relaxed);
+        pool.next_slab.store(nullptr, std::memory_order_relaxed);
+        std::free(pool.slab_class);
+        pool.slab_class = nullptr;
+        munmap(mapping, mapped_bytes);
+        return false;
+    }
+    return true;
+}
+
+bool vdbfusion::LeafPool::Enabled() const { return pool.enabled.load(std::memory_order_acquire); }
+
+void* vdbfusion::LeafPool::Allocate(size_t size) {
+    if (scope_depth == 0 || !Enabled()) {
+        return nullptr;
+    }
+    const int cls = ClassFor(size);
+    if (cls < 0) {
+        return nullptr;
+    }
+    (void)&local_cache_flusher;
+    auto& cache = local_cache;
+    void* ptr = nullptr;
+    if (FreeBlock* block = cache.head[cls]) {
+        cache.head[cls] = block->next;
+        --cache.count[cls];
+        ptr = block;
+    } else {
+        ptr = Refill(cls);
+    }
+    if (ptr != nullptr) {
+        pool.allocations.fetch_add(1, std::memory_order_relaxed);
+    }
+    return ptr;
+}
+
+bool vdbfusion::LeafPool::Deallocate(void* ptr) {
+    auto* p = static_cast<char*>(ptr);
+    char* begin = pool.begin.load(std::memory_order_relaxed);
+    if (p < begin || p >= pool.end.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    // Blocks never straddle slabs, the owning size class is the one that carved the slab
+    const int cls = pool.slab_class[static_cast<size_t>(p - begin) / kSlabSize];
+    pool.deallocations.fetch_add(1, std::memory_order_relaxed);
+    auto* block = static_cast<FreeBlock*>(ptr);
+    auto& cache = local_cache;
+    if (cache.flushed) {
+        auto& size_class = pool.classes[cls];
+        std::lock_guard<std::mutex> lock(size_class.mutex);
+        block->next = size_class.free_list;
+        size_class.free_list = block;
+        return true;
+    }
+    (void)&local_cache_flusher;
+    block->next = cache.head[cls];
+    cache.head[cls] = block;
+    if (++cache.count[cls] > 2 * kBatch) {
+        ReleaseBlocks(cls, kBatch);
+    }
+    return true;
+}
+
+vdbfusion::LeafAllocationScope::LeafAllocationScope() { ++scope_depth; }
+
+vdbfusion::LeafAllocationScope::~LeafAllocationScope() { --scope_depth; }
+
+vdbfusion::LeafPoolStats vdbfusion::LeafPool::Stats() const {
+    LeafPoolStats stats;
+    stats.slabs = pool.slabs.load(std::memory_order_relaxed);
+    stats.reserved_bytes = static_cast<size_t>(pool.end.load() - pool.begin.load());
+    stats.allocations = pool.allocations.load(std::memory_order_relaxed);
+    stats.deallocations = pool.deallocations.load(std::memory_order_relaxed);
+    stats.live_blocks = stats.allocations - stats.deallocations;
+    stats.refill_seconds = static_cast<double>(pool.refill_ns.load()) * 1e-9;
+    return stats;
+}
+
+size_t vdbfusion::ResidentSetSize() {
+    FILE* statm = std::fopen("/proc/self/statm", "r");
+    if (statm == nullptr) {
+        return 0;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    const int n_read = std::fscanf(statm, "%lu %lu", &size, &resident);
+    std::fclose(statm);
+    return n_read == 2 ? resident * static_cast<size_t>(sysconf(_SC_PAGESIZE)) : 0;
+}
+
+size_t vdbfusion::PeakResidentSetSize() {
+    FILE* status = std::fopen("/proc/self/status", "r");
+    if (status == nullptr) {
+        return 0;
+    }
+    char line[256];
+    unsigned long peak_kb = 0;
+    while (std::fgets(line, sizeof(line), status) != nullptr) {
+        if (std::sscanf(line, "VmHWM: %lu kB", &peak_kb) == 1) {
+            break;
+        }
+    }
+    std::fclose(status);
+    return static_cast<size_t>(peak_kb) << 10;
+}
+
+bool vdbfusion::ResetPeakResidentSetSize() {
+    FILE* clear_refs = std::fopen("/proc/self/clear_refs", "w");
+    if (clear_refs == nullptr) {
+        return false;
+    }
+    const bool written = std::fputs("5", clear_refs) >= 0;
+    return std::fclose(clear_refs) == 0 && written;
+}
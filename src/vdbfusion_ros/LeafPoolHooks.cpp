@@ -0,0 +1,54 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <cstdlib>
+#include <new>
+
+#include "LeafPool.hpp"
+
+// Replacing the global allocation functions is the only hook OpenVDB offers into the allocation
+// of its leaf nodes and buffers. This file is only compiled into the executables that may enable
+// the leaf pool, and even there the pool only serves the leaf sized requests made inside a
+// LeafAllocationScope, see LeafPool. Everything else goes straight to malloc.
+void* operator new(std::size_t size) {
+    if (void* ptr = vdbfusion::LeafPool::Instance().Allocate(size)) {
+        return ptr;
+    }
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void* ptr) noexcept {
+    if (!vdbfusion::LeafPool::Instance().Deallocate(ptr)) {
+        std::free(ptr);
+    }
+}
+
+void operator delete[](void* ptr) noexcept { ::operator delete(ptr); }
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept { ::operator delete(ptr); }
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept { ::operator delete(ptr); }
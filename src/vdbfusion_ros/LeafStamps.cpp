@@ -0,0 +1,85 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "LeafStamps.hpp"
+
+#include <openvdb/math/DDA.h>
+#include <openvdb/math/Ray.h>
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <vector>
+
+void vdbfusion::TouchedLeaves::AddRays(const openvdb::FloatGrid& grid,
+                                       float sdf_trunc,
+                                       bool space_carving,
+                                       const ScanBatch& batch) {
+    using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+    const auto& xform = grid.transform();
+    // One voxel more than the band, the traversals start from the floor of the band entry
+    const int band = static_cast<int>(std::ceil(sdf_trunc / xform.voxelSize()[0])) + 1;
+    const openvdb::Int32 leaf_mask = ~static_cast<openvdb::Int32>(LeafT::DIM - 1);
+    for (size_t scan = 0; scan < batch.size(); ++scan) {
+        const Eigen::Vector3d& origin = batch.origins[scan];
+        const openvdb::Vec3R eye(origin.x(), origin.y(), origin.z());
+        for (const auto& point : batch.points[scan]) {
+            const openvdb::Coord ijk =
+                xform.worldToIndexCellCentered(openvdb::Vec3d(point.x(), point.y(), point.z()));
+            const openvdb::Coord min = ijk.offsetBy(-band);
+            const openvdb::Coord max = ijk.offsetBy(band);
+            for (openvdb::Int32 x = min.x() & leaf_mask; x <= max.x(); x += LeafT::DIM) {
+                for (openvdb::Int32 y = min.y() & leaf_mask; y <= max.y(); y += LeafT::DIM) {
+                    for (openvdb::Int32 z = min.z() & leaf_mask; z <= max.z(); z += LeafT::DIM) {
+                        Add(openvdb::Coord(x, y, z));
+                    }
+                }
+            }
+            if (space_carving) {
+                const Eigen::Vector3d direction = point - origin;
+                openvdb::Vec3R dir(direction.x(), direction.y(), direction.z());
+                dir.normalize();
+                const auto ray =
+                    openvdb::math::Ray<double>(eye, dir, 0.0, direction.norm() + sdf_trunc)
+                        .worldToIndex(grid);
+                openvdb::math::DDA<decltype(ray), LeafT::TOTAL> dda(ray);
+                do {
+                    Add(dda.voxel());
+                } while (dda.step());
+            }
+        }
+    }
+}
+
+const std::vector<openvdb::Coord>& vdbfusion::TouchedLeaves::Sorted() {
+    std::sort(origins_.begin(), origins_.end());
+    origins_.erase(std::unique(origins_.begin(), origins_.end()), origins_.end());
+    return origins_;
+}
+
+void vdbfusion::TouchedLeaves::clear() {
+    origins_.clear();
+    // Leaf origins are multiples of the leaf size, this one is not
+    recent_.fill(openvdb::Coord(std::numeric_limits<openvdb::Int32>::max()));
+}
@@ -0,0 +1,64 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "Log.hpp"
+
+#include <cstdarg>
+#include <cstdio>
+#include <string>
+#include <utility>
+
+namespace {
+vdbfusion::LogSink& Sink() {
+    static vdbfusion::LogSink sink;
+    return sink;
+}
+
+void Log(vdbfusion::LogLevel level, const char* format, va_list args) {
+    char message[1024];
+    std::vsnprintf(message, sizeof(message), format, args);
+    const auto& sink = Sink();
+    if (sink) {
+        sink(level, message);
+        return;
+    }
+    std::fprintf(stderr, "[%s] %s\n", level == vdbfusion::LogLevel::kWarn ? "WARN" : "INFO",
+                 message);
+}
+}  // namespace
+
+void vdbfusion::SetLogSink(LogSink sink) { Sink() = std::move(sink); }
+
+void vdbfusion::LogInfo(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    Log(LogLevel::kInfo, format, args);
+    va_end(args);
+}
+
+void vdbfusion::LogWarn(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    Log(LogLevel::kWarn, format, args);
+    va_end(args);
+}
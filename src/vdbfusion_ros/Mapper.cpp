@@ -0,0 +1,369 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Mapper.hpp"
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "HardwareCounters.hpp"
+#include "LeafPool.hpp"
+#include "Log.hpp"
+#include "RayPackets.hpp"
+#include "VolumeIO.hpp"
+#include "openvdb/openvdb.h"
+#include "openvdb/tools/Prune.h"
+
+namespace {
+vdbfusion::VDBVolume MakeVolume(const vdbfusion::MapperConfig& config) {
+    openvdb::initialize();
+    // The pool has to be in place before the grids allocate their first leaf
+    if (config.leaf_pool &&
+        !vdbfusion::LeafPool::Instance().Enable(config.leaf_pool_reserve_bytes,
+                                                config.leaf_pool_huge_pages)) {
+        LogWarn("Could not reserve the leaf pool, or the executable does not link its "
+                "allocation hooks, falling back to the system allocator");
+    }
+    return vdbfusion::VDBVolume(config.voxel_size, config.sdf_trunc, config.space_carving);
+}
+}  // namespace
+
+vdbfusion::Mapper::Mapper(const MapperConfig& config)
+    : config_(config),
+      vdb_volume_(MakeVolume(config)),
+      snapshots_(config.retain_snapshots) {
+    if (config_.projective) {
+        range_image_ = std::make_unique<RangeImage>(config_.lidar);
+    }
+
+    if (config_.beam_model) {
+        beam_model_ = std::make_unique<BeamModel>(config_.beam_model_learning_scans,
+                                                  config_.beam_model_tolerance);
+        if (!config_.beam_model_file.empty() && beam_model_->Load(config_.beam_model_file)) {
+            LogInfo("Loaded beam model from %s", config_.beam_model_file.c_str());
+        }
+    }
+
+    if (config_.fused_layout && (config_.projective || config_.beam_model)) {
+        LogWarn("The fused layout only supports raycast integration, using the split layout");
+        config_.fused_layout = false;
+    }
+    if (config_.fused_layout) {
+        fused_volume_ = MakeFusedVolume(config_.leaf_dim, config_.voxel_size, config_.sdf_trunc,
+                                        config_.space_carving);
+        if (!fused_volume_) {
+            LogWarn("Unsupported leaf_dim %d, using 8^3 voxel leaves", config_.leaf_dim);
+            config_.leaf_dim = 8;
+            fused_volume_ = MakeFusedVolume(8, config_.voxel_size, config_.sdf_trunc,
+                                            config_.space_carving);
+        }
+    }
+
+    // The time window and the pose corrections both replay the recorded scans
+    if (config_.pose_corrections && !config_.apply_pose) {
+        LogWarn("Pose corrections need apply_pose, ignoring them");
+        config_.pose_corrections = false;
+    }
+    if (config_.window_duration > 0.0 || config_.pose_corrections) {
+        if (config_.projective || config_.beam_model || config_.fused_layout ||
+            config_.space_carving) {
+            LogWarn("The time window and the pose corrections need raycast integration into the "
+                    "split layout without beam model or space carving, both are disabled");
+            config_.window_duration = 0.0;
+            config_.pose_corrections = false;
+        } else {
+            history_ = std::make_unique<ScanHistory>(config_.window_duration);
+            // De-integration replays the packet traversal, integration has to visit the same
+            // voxels with the same distances
+            config_.ray_packets = true;
+        }
+    }
+
+    if (config_.stream_deltas && config_.fused_layout) {
+        LogWarn("Leaf streaming needs the split layout, streaming disabled");
+        config_.stream_deltas = false;
+    }
+
+    if (config_.eviction && config_.fused_layout) {
+        LogWarn("Leaf eviction needs the split layout, eviction disabled");
+        config_.eviction = false;
+    }
+    if (config_.eviction) {
+        evictor_ = std::make_unique<TransientLeafEvictor>(config_.eviction_max_weight,
+                                                          config_.eviction_age);
+    }
+
+    if (config_.hardware_counters && !HardwareCounters::Instance().Enable()) {
+        LogWarn("Hardware counters are not available (perf_event_paranoid, container or virtual "
+                "machine?), only the stage times are recorded");
+        config_.hardware_counters = false;
+    }
+}
+
+void vdbfusion::Mapper::Integrate(const ScanDecoder& decode,
+                                  double stamp,
+                                  const Sophus::SE3d& pose) {
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    // Without apply_pose the points stay in the sensor frame and are observed from its origin
+    const Sophus::SE3d T = config_.apply_pose ? pose : Sophus::SE3d();
+    last_origin_ = T.translation();
+    last_stamp_ = stamp;
+    auto& scan = arena_.scan;
+    // Beam decoding relies on the (row, column) layout of the organized scan
+    bool organized;
+    {
+        ScopedStage stage(stats_, Stage::kDecode);
+        organized = decode(scan, beam_model_ && !config_.projective);
+    }
+
+    // Beam decoding works on the organized scan, filtered returns are skipped there
+    if (organized) {
+        {
+            ScopedStage stage(stats_, Stage::kFilter);
+            ComputeKeepMask(scan, config_.filter);
+        }
+        bool decoded;
+        {
+            ScopedStage stage(stats_, Stage::kDecode);
+            decoded = beam_model_->Decode(scan, arena_.beam_scan);
+        }
+        if (decoded) {
+            ScopedStage stage(stats_, Stage::kIntegrate);
+            LeafAllocationScope leaves;
+            IntegrateBeams(vdb_volume_, *beam_model_, arena_.beam_scan, T, weighting_function_,
+                           arena_.touched);
+            CommitTouched();
+            return;
+        }
+        // Scans are raycast as usual until the beam layout is known, and whenever their points
+        // left the learned beams
+        if (beam_model_->Ready() && beam_model_->Matches(scan)) {
+            if (!warned_beam_mismatch_) {
+                LogWarn("Scan points deviate from the learned beam directions by more than "
+                        "beam_model_tolerance_deg, raycasting such scans");
+                warned_beam_mismatch_ = true;
+            }
+        } else if (beam_model_->Learn(scan)) {
+            LogInfo("Beam model learned, switching to cached beam directions");
+            if (!config_.beam_model_file.empty() && beam_model_->Save(config_.beam_model_file)) {
+                LogInfo("Saved beam model to %s", config_.beam_model_file.c_str());
+            }
+        }
+    }
+
+    {
+        ScopedStage stage(stats_, Stage::kFilter);
+        ApplyFilter(scan, config_.filter);
+        if (config_.voxel_filter_size > 0.0f) {
+            VoxelFilter(scan, config_.voxel_filter_size);
+        }
+    }
+
+    if (config_.projective) {
+        ScopedStage stage(stats_, Stage::kIntegrate);
+        LeafAllocationScope leaves;
+        // The range image lives in the sensor frame, the pose is applied per voxel
+        range_image_->Build(scan);
+        IntegrateProjective(vdb_volume_, *range_image_, T, weighting_function_,
+                            arena_.projective);
+        for (const auto& origin : arena_.projective.leaf_origins) {
+            arena_.touched.Add(origin);
+        }
+        CommitTouched();
+        return;
+    }
+    // Raycast scans are integrated in batches of batch_scans scans, or of whatever arrived
+    // within batch_latency of sensor time
+    if (arena_.batch.empty()) {
+        batch_start_ = stamp;
+    }
+    {
+        ScopedStage stage(stats_, Stage::kTransform);
+        auto& points = arena_.batch.Add(T.translation());
+        ToWorld(scan, T, points);
+        if (history_) {
+            history_->Add(stamp, T, points);
+        }
+    }
+    const bool batch_full = static_cast<int>(arena_.batch.size()) >= config_.batch_scans;
+    const bool batch_expired =
+        config_.batch_latency > 0.0 && stamp - batch_start_ >= config_.batch_latency;
+    if (batch_full || batch_expired) {
+        IntegrateBatch();
+    }
+}
+
+void vdbfusion::Mapper::Flush() {
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    if (!arena_.batch.empty()) {
+        IntegrateBatch();
+    }
+}
+
+void vdbfusion::Mapper::IntegrateBatch() {
+    auto& batch = arena_.batch;
+    {
+        ScopedStage stage(stats_, Stage::kIntegrate);
+        arena_.touched.AddRays(*vdb_volume_.tsdf_, config_.sdf_trunc, config_.space_carving,
+                               batch);
+        LeafAllocationScope leaves;
+        if (fused_volume_) {
+            fused_volume_->Integrate(batch);
+        } else if (config_.ray_packets) {
+            IntegratePackets(vdb_volume_, batch, arena_.packets);
+        } else {
+            for (size_t scan = 0; scan < batch.size(); ++scan) {
+                vdb_volume_.Integrate(batch.points[scan], batch.origins[scan],
+                                      weighting_function_);
+            }
+        }
+        batch.clear();
+    }
+
+    // Scans leave the window only once everything recorded after them has been integrated
+    if (history_ && history_->Expire(arena_.expired)) {
+        DeintegrateExpired();
+    }
+    CommitTouched();
+}
+
+void vdbfusion::Mapper::DeintegrateExpired() {
+    ScopedStage stage(stats_, Stage::kDeintegrate);
+    arena_.touched.AddRays(*vdb_volume_.tsdf_, config_.sdf_trunc, false, arena_.expired);
+    DeintegratePackets(vdb_volume_, arena_.expired, arena_.packets);
+    // Leaves whose every voxel was switched off go away
+    openvdb::tools::pruneInactive(vdb_volume_.tsdf_->tree());
+    openvdb::tools::pruneInactive(vdb_volume_.weights_->tree());
+}
+
+void vdbfusion::Mapper::CommitTouched() {
+    if (arena_.touched.empty()) {
+        return;
+    }
+    const auto& origins = arena_.touched.Sorted();
+    snapshots_.MarkDirty(origins);
+    if (config_.stream_deltas) {
+        delta_encoder_.MarkDirty(origins);
+    }
+    if (evictor_) {
+        evictor_->Touch(origins, last_stamp_);
+    }
+    arena_.touched.clear();
+}
+
+size_t vdbfusion::Mapper::CorrectPoses(const std::vector<PoseCorrection>& corrections) {
+    if (!history_ || !config_.pose_corrections) {
+        return 0;
+    }
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    // Every recorded scan has to be in the volume before it can be taken out again
+    if (!arena_.batch.empty()) {
+        IntegrateBatch();
+    }
+    const size_t n_corrected = history_->Correct(
+        corrections, config_.correction_tolerance, config_.correction_translation,
+        config_.correction_rotation, arena_.expired, arena_.batch);
+    if (n_corrected == 0) {
+        return 0;
+    }
+    DeintegrateExpired();
+    IntegrateBatch();
+    LogInfo("Re-integrated %zu of %zu scans with corrected poses", n_corrected, history_->size());
+    return n_corrected;
+}
+
+vdbfusion::EvictionStats vdbfusion::Mapper::EvictTransients(double now) {
+    if (!evictor_) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    return Evict(now);
+}
+
+vdbfusion::EvictionStats vdbfusion::Mapper::EvictTransients() {
+    if (!evictor_) {
+        return {};
+    }
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    return Evict(last_stamp_);
+}
+
+vdbfusion::EvictionStats vdbfusion::Mapper::Evict(double now) {
+    const EvictionStats stats = evictor_->Evict(vdb_volume_, now, arena_.touched);
+    // Only the snapshots and the stream have to learn about the evicted leaves
+    if (!arena_.touched.empty()) {
+        const auto& origins = arena_.touched.Sorted();
+        snapshots_.MarkDirty(origins);
+        if (config_.stream_deltas) {
+            delta_encoder_.MarkDirty(origins);
+        }
+        arena_.touched.clear();
+    }
+    return stats;
+}
+
+bool vdbfusion::Mapper::EncodeDelta(size_t budget_bytes, LeafDelta& delta) {
+    if (fused_volume_) {
+        return false;
+    }
+    std::lock_guard<std::mutex> delta_lock(delta_mutex_);
+    {
+        // Integration only waits while the touched leaves are copied, not for the compression
+        std::lock_guard<std::mutex> lock(volume_mutex_);
+        delta_encoder_.Collect(vdb_volume_, last_origin_);
+    }
+    delta_encoder_.Encode(budget_bytes, delta);
+    return delta.full || !delta.leaf_bytes.empty() || !delta.removed_origins.empty();
+}
+
+void vdbfusion::Mapper::ResetDeltas() {
+    std::lock_guard<std::mutex> delta_lock(delta_mutex_);
+    delta_encoder_.Reset();
+}
+
+std::shared_ptr<const vdbfusion::VolumeSnapshot> vdbfusion::Mapper::Snapshot() {
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    if (!arena_.batch.empty()) {
+        IntegrateBatch();
+    }
+    if (fused_volume_) {
+        return snapshots_.Take(*fused_volume_);
+    }
+    return snapshots_.Take(vdb_volume_);
+}
+
+vdbfusion::PipelineStats vdbfusion::Mapper::Stats() {
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    return stats_;
+}
+
+void vdbfusion::Mapper::ResetStats() {
+    std::lock_guard<std::mutex> lock(volume_mutex_);
+    stats_.Reset();
+}
+
+void vdbfusion::Mapper::Save(const std::string& prefix) {
+    const auto snapshot = Snapshot();
+    SaveVDBVolume(snapshot->ToVDBVolume(), prefix, config_.fill_holes, config_.min_weight);
+}
@@ -0,0 +1,72 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "MapperMsgs.hpp"
+
+#include <ros/console.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <cstddef>
+
+#include "Decode.hpp"
+#include "Mapper.hpp"
+#include "ScanBuffer.hpp"
+#include "VolumeStream.hpp"
+#include "vdbfusion_ros/VolumeDelta.h"
+
+void vdbfusion::IntegrateCloud(Mapper& mapper,
+                               const sensor_msgs::PointCloud2& pcd,
+                               const Sophus::SE3d& pose) {
+    const auto decode = [&pcd](ScanBuffer& scan, bool keep_layout) {
+        const bool organized = keep_layout && pcd.height > 1;
+        const size_t n_invalid = pcl2SensorMsgToScanBuffer(pcd, scan, organized);
+        if (n_invalid > 0) {
+            ROS_INFO("Skipped %zu invalid points out of %zu", n_invalid,
+                     static_cast<size_t>(pcd.width) * pcd.height);
+        }
+        return organized;
+    };
+    mapper.Integrate(decode, pcd.header.stamp.toSec(), pose);
+}
+
+void vdbfusion::SwapIntoMsg(LeafDelta& delta, vdbfusion_ros::VolumeDelta& msg) {
+    msg.version = delta.version;
+    msg.full = delta.full;
+    msg.voxel_size = delta.voxel_size;
+    msg.sdf_trunc = delta.sdf_trunc;
+    msg.removed_origins.swap(delta.removed_origins);
+    msg.leaf_origins.swap(delta.leaf_origins);
+    msg.leaf_bytes.swap(delta.leaf_bytes);
+    msg.data.swap(delta.data);
+}
+
+void vdbfusion::FromMsg(const vdbfusion_ros::VolumeDelta& msg, LeafDelta& delta) {
+    delta.version = msg.version;
+    delta.full = msg.full;
+    delta.voxel_size = msg.voxel_size;
+    delta.sdf_trunc = msg.sdf_trunc;
+    delta.removed_origins = msg.removed_origins;
+    delta.leaf_origins = msg.leaf_origins;
+    delta.leaf_bytes = msg.leaf_bytes;
+    delta.data = msg.data;
+}
@@ -0,0 +1,148 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "MapperParams.hpp"
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "Log.hpp"
+#include "Mapper.hpp"
+#include "ParamSource.hpp"
+
+namespace {
+// Boxes are given as [min_x, min_y, min_z, max_x, max_y, max_z] in the sensor frame
+std::vector<vdbfusion::CropBox> ReadCropBoxes(const vdbfusion::ParamSource& params,
+                                              const std::string& name) {
+    std::vector<vdbfusion::CropBox> boxes;
+    std::vector<std::vector<float>> list;
+    if (!params.Get(name, list)) {
+        return boxes;
+    }
+    for (size_t i = 0; i < list.size(); ++i) {
+        const auto& box = list[i];
+        if (box.size() != 6) {
+            vdbfusion::LogWarn("Ignoring %s[%zu], expected 6 values", name.c_str(), i);
+            continue;
+        }
+        boxes.push_back({Eigen::Vector3f(box[0], box[1], box[2]),
+                         Eigen::Vector3f(box[3], box[4], box[5])});
+    }
+    return boxes;
+}
+
+vdbfusion::LiDARIntrinsics ReadLiDARIntrinsics(const vdbfusion::ParamSource& params) {
+    vdbfusion::LiDARIntrinsics intrinsics{64, 2048, 0.0f, 0.0f, {}};
+    float fov_up = 2.0f;
+    float fov_down = -24.8f;
+    std::vector<float> beam_elevations;
+
+    params.Get("lidar_rings", intrinsics.rings);
+    params.Get("lidar_azimuth_bins", intrinsics.azimuth_bins);
+    params.Get("lidar_fov_up", fov_up);
+    params.Get("lidar_fov_down", fov_down);
+    params.Get("lidar_beam_elevations", beam_elevations);
+
+    const auto deg2rad = [](float angle) { return angle * static_cast<float>(M_PI) / 180.0f; };
+    intrinsics.fov_up = deg2rad(fov_up);
+    intrinsics.fov_down = deg2rad(fov_down);
+    std::transform(beam_elevations.cbegin(), beam_elevations.cend(),
+                   std::back_inserter(intrinsics.beam_elevations), deg2rad);
+    return intrinsics;
+}
+}  // namespace
+
+vdbfusion::MapperConfig vdbfusion::ReadMapperConfig(const ParamSource& params) {
+    MapperConfig config;
+    params.Get("voxel_size", config.voxel_size);
+    params.Get("sdf_trunc", config.sdf_trunc);
+    params.Get("space_carving", config.space_carving);
+
+    int reserve_gb = 64;
+    params.Get("leaf_pool", config.leaf_pool);
+    params.Get("leaf_pool_reserve_gb", reserve_gb);
+    params.Get("leaf_pool_huge_pages", config.leaf_pool_huge_pages);
+    config.leaf_pool_reserve_bytes = static_cast<size_t>(reserve_gb) << 30;
+
+    bool preprocess = false;
+    params.Get("preprocess", preprocess);
+    params.Get("apply_pose", config.apply_pose);
+    if (preprocess) {
+        params.Get("min_range", config.filter.min_range);
+        params.Get("max_range", config.filter.max_range);
+    }
+    config.filter.exclusion_boxes = ReadCropBoxes(params, "exclusion_boxes");
+    config.filter.inclusion_boxes = ReadCropBoxes(params, "inclusion_boxes");
+    params.Get("voxel_filter_size", config.voxel_filter_size);
+
+    std::string integration_mode = "raycast";
+    params.Get("integration_mode", integration_mode);
+    config.projective = integration_mode == "projective";
+    if (config.projective) {
+        config.lidar = ReadLiDARIntrinsics(params);
+    }
+    double batch_latency_ms = 0.0;
+    params.Get("ray_packets", config.ray_packets);
+    params.Get("batch_scans", config.batch_scans);
+    params.Get("batch_latency_ms", batch_latency_ms);
+    config.batch_latency = batch_latency_ms * 1e-3;
+    std::string volume_layout = "split";
+    params.Get("volume_layout", volume_layout);
+    config.fused_layout = volume_layout == "fused";
+    params.Get("leaf_dim", config.leaf_dim);
+
+    params.Get("beam_model", config.beam_model);
+    params.Get("beam_model_learning_scans", config.beam_model_learning_scans);
+    params.Get("beam_model_file", config.beam_model_file);
+    double beam_tolerance_deg = 1.0;
+    params.Get("beam_model_tolerance_deg", beam_tolerance_deg);
+    config.beam_model_tolerance = beam_tolerance_deg * M_PI / 180.0;
+
+    int tolerance_ns = 0;
+    double rotation_deg = 1.0;
+    params.Get("window_duration", config.window_duration);
+    params.Get("pose_corrections", config.pose_corrections);
+    params.Get("timestamp_tolerance_ns", tolerance_ns);
+    config.correction_tolerance = tolerance_ns * 1e-9;
+    params.Get("correction_translation_threshold", config.correction_translation);
+    params.Get("correction_rotation_threshold", rotation_deg);
+    config.correction_rotation = rotation_deg * M_PI / 180.0;
+
+    params.Get("eviction_period", config.eviction_period);
+    config.eviction = config.eviction_period > 0.0;
+    params.Get("eviction_max_weight", config.eviction_max_weight);
+    params.Get("eviction_age", config.eviction_age);
+
+    params.Get("retain_snapshots", config.retain_snapshots);
+
+    params.Get("stream_deltas", config.stream_deltas);
+
+    params.Get("fill_holes", config.fill_holes);
+    params.Get("min_weight", config.min_weight);
+
+    params.Get("hardware_counters", config.hardware_counters);
+    return config;
+}
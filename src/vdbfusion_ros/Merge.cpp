@@ -0,0 +1,114 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "VolumeIO.hpp"
+#include "openvdb/openvdb.h"
+#include "sophus/se3.hpp"
+
+namespace {
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--min_weight <float>] [--fill_holes] <output_prefix>"
+                 " [--pose <tx> <ty> <tz> <qx> <qy> <qz> <qw>] <grid.vdb>...\n"
+              << "Merges the tsdf and weights grids into <output_prefix>_grid.vdb and "
+                 "<output_prefix>_mesh.ply.\n"
+              << "A --pose maps the world frame of the grid that follows it into the merged frame, "
+                 "grids without one are taken as is.\n";
+}
+
+struct MergeInput {
+    std::string filename;
+    Sophus::SE3d T_merged_grid;
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+    float min_weight = 0.0f;
+    bool fill_holes = false;
+    std::optional<std::string> output_prefix;
+    std::vector<MergeInput> inputs;
+    Sophus::SE3d pose;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--min_weight" && i + 1 < argc) {
+            min_weight = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--fill_holes") {
+            fill_holes = true;
+        } else if (arg == "--pose" && i + 7 < argc) {
+            double values[7];
+            for (double& value : values) {
+                value = std::strtod(argv[++i], nullptr);
+            }
+            const Eigen::Quaterniond q(values[6], values[3], values[4], values[5]);
+            pose = Sophus::SE3d(q.normalized(), Eigen::Vector3d(values[0], values[1], values[2]));
+        } else if (!output_prefix) {
+            output_prefix = arg;
+        } else {
+            inputs.push_back({arg, pose});
+            pose = Sophus::SE3d();
+        }
+    }
+    if (!output_prefix || inputs.empty()) {
+        PrintUsage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    openvdb::initialize();
+    const auto start = std::chrono::steady_clock::now();
+    std::optional<vdbfusion::VDBVolume> merged;
+    for (const auto& input : inputs) {
+        auto volume = vdbfusion::LoadVDBVolume(input.filename);
+        if (!volume) {
+            std::cerr << "Could not read the tsdf grid of " << input.filename << "\n";
+            return EXIT_FAILURE;
+        }
+        if (!merged) {
+            // The merged volume takes the parameters of the first grid
+            merged.emplace(volume->voxel_size_, volume->sdf_trunc_, false);
+        }
+        if (!vdbfusion::MergeVolume(*merged, *volume, input.T_merged_grid)) {
+            std::cerr << "Voxel size of " << input.filename << " does not match "
+                      << inputs.front().filename << "\n";
+            return EXIT_FAILURE;
+        }
+        std::cout << "Merged " << input.filename << " ("
+                  << volume->weights_->tree().leafCount() << " leaves)\n";
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    std::cout << "Merged " << inputs.size() << " grids into "
+              << merged->weights_->tree().leafCount() << " leaves in " << elapsed.count()
+              << " s\n";
+
+    vdbfusion::SaveVDBVolume(*merged, *output_prefix, fill_holes, min_weight);
+    std::cout << "Saved " << *output_prefix << "_grid.vdb and " << *output_prefix
+              << "_mesh.ply\n";
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,534 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <ros/console.h>
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "HardwareCounters.hpp"
+#include "LeafPool.hpp"
+#include "Mapper.hpp"
+#include "MapperMsgs.hpp"
+#include "PoseBuffer.hpp"
+#include "SyntheticScans.hpp"
+#include "openvdb/openvdb.h"
+#include "sophus/se3.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+constexpr int kLeafAllocations = 200000;
+// Exit code of a run against a baseline that lacks one of the workloads it ran
+constexpr int kMissingBaseline = 3;
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--scans <int>] [--repeat <int>] [--workload <name>] [--output <report.json>]"
+                 " [--baseline <baseline.json>] [--tolerances <tolerances.yaml>]"
+                 " [--tolerance <percent>] [--memory_tolerance <percent>]\n"
+              << "Runs the synthetic integration (raycast, packets, fused, projective, beam "
+                 "model), meshing, saving, pose lookup and leaf pool workloads, or only the named "
+                 "one, and compares them against the baseline. A report written with --output is "
+                 "a valid baseline. Exits with 1 if a workload is slower or larger than the "
+                 "tolerances allow, and with 3 if a workload that ran has no baseline values.\n";
+}
+
+struct Options {
+    int scans = 20;
+    int repeat = 3;
+    double tolerance = 10.0;
+    double memory_tolerance = 20.0;
+    std::string workload;
+    std::string output;
+    std::string baseline;
+    std::string tolerances;
+};
+
+struct WorkloadResult {
+    std::string name;
+    std::string unit;
+    double throughput = 0.0;
+    double seconds = 0.0;
+    double peak_rss_mb = 0.0;
+    // dTLB misses of the timed section per unit of work, 0 without hardware counters
+    double dtlb_misses = 0.0;
+};
+
+// Amount of work done and the seconds it took, setup excluded
+struct Measurement {
+    double work;
+    double seconds;
+    double dtlb_misses = 0.0;
+};
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// Best throughput over the repetitions, the peak memory of the worst one
+template <typename Workload>
+WorkloadResult Run(const std::string& name,
+                   const std::string& unit,
+                   int repeat,
+                   const Workload& workload) {
+    WorkloadResult result{name, unit};
+    for (int i = 0; i < repeat; ++i) {
+        vdbfusion::ResetPeakResidentSetSize();
+        const Measurement measurement = workload();
+        const double peak_mb =
+            static_cast<double>(vdbfusion::PeakResidentSetSize()) / (1 << 20);
+        const double throughput =
+            measurement.seconds > 0.0 ? measurement.work / measurement.seconds : 0.0;
+        if (throughput > result.throughput) {
+            result.throughput = throughput;
+            result.seconds = measurement.seconds;
+            result.dtlb_misses = measurement.work > 0.0 ? measurement.dtlb_misses / measurement.work
+                                                        : 0.0;
+        }
+        result.peak_rss_mb = std::max(result.peak_rss_mb, peak_mb);
+    }
+    std::printf("%-24s %14.1f %-10s %8.3f s %9.1f MB %10.4f dTLB/unit\n", name.c_str(),
+                result.throughput, unit.c_str(), result.seconds, result.peak_rss_mb,
+                result.dtlb_misses);
+    return result;
+}
+
+struct Sequence {
+    std::vector<sensor_msgs::PointCloud2> scans;
+    std::vector<Sophus::SE3d> poses;
+    double points = 0.0;
+};
+
+// 10 Hz sweeps of a 64 ring LiDAR driving down the corridor, rendered outside the timed section
+Sequence RenderSequence(const vdbfusion::SyntheticSensor& sensor, int n_scans) {
+    const vdbfusion::SyntheticScene scene;
+    Sequence sequence;
+    sequence.scans.resize(n_scans);
+    for (int i = 0; i < n_scans; ++i) {
+        const double t = 0.1 * i;
+        sequence.poses.push_back(vdbfusion::CorridorPose(scene, t, 2.0));
+        vdbfusion::RenderScan(scene, sensor, sequence.poses.back(), ros::Time(1.0 + t), i,
+                              sequence.scans[i]);
+        sequence.points += static_cast<double>(sequence.scans[i].width) * sequence.scans[i].height;
+    }
+    return sequence;
+}
+
+vdbfusion::MapperConfig BaseConfig() {
+    vdbfusion::MapperConfig config;
+    config.voxel_size = 0.1f;
+    config.sdf_trunc = 0.3f;
+    config.filter.min_range = 0.5f;
+    config.filter.max_range = 50.0f;
+    return config;
+}
+
+void IntegrateSequence(vdbfusion::Mapper& mapper, const Sequence& sequence, size_t first = 0) {
+    for (size_t i = first; i < sequence.scans.size(); ++i) {
+        vdbfusion::IntegrateCloud(mapper, sequence.scans[i], sequence.poses[i]);
+    }
+    mapper.Flush();
+}
+
+// The first warmup scans are integrated before the clock starts, e.g. to learn the beam model
+Measurement IntegrationWorkload(const vdbfusion::MapperConfig& config,
+                                const Sequence& sequence,
+                                size_t warmup = 0) {
+    vdbfusion::Mapper mapper(config);
+    double points = sequence.points;
+    for (size_t i = 0; i < warmup && i < sequence.scans.size(); ++i) {
+        vdbfusion::IntegrateCloud(mapper, sequence.scans[i], sequence.poses[i]);
+        points -= static_cast<double>(sequence.scans[i].width) * sequence.scans[i].height;
+    }
+    // Stats() returns a copy, the counters are read out of it right away
+    const size_t dtlb = static_cast<size_t>(vdbfusion::Counter::kDTLBMisses);
+    const auto warmup_dtlb_misses = mapper.Stats()[vdbfusion::Stage::kIntegrate].counters[dtlb];
+    const auto start = Clock::now();
+    IntegrateSequence(mapper, sequence, warmup);
+    const double seconds = SecondsSince(start);
+    const auto dtlb_misses = mapper.Stats()[vdbfusion::Stage::kIntegrate].counters[dtlb];
+    return {points, seconds, static_cast<double>(dtlb_misses - warmup_dtlb_misses)};
+}
+
+// Adds a block of leaves the way integration does, one touchLeaf per new leaf
+Measurement LeafAllocationWorkload(int n_leaves) {
+    using LeafT = openvdb::FloatTree::LeafNodeType;
+    openvdb::initialize();
+    const int side = static_cast<int>(std::ceil(std::cbrt(n_leaves)));
+    vdbfusion::CounterValues before;
+    vdbfusion::CounterValues after;
+    openvdb::FloatTree tree(0.0f);
+    vdbfusion::HardwareCounters::Instance().Read(before);
+    const auto start = Clock::now();
+    {
+        vdbfusion::LeafAllocationScope leaves;
+        for (int i = 0; i < n_leaves; ++i) {
+            const openvdb::Coord leaf(i % side, (i / side) % side, i / (side * side));
+            tree.touchLeaf(leaf * LeafT::DIM)->setValueOn(0, 1.0f);
+        }
+    }
+    const double seconds = SecondsSince(start);
+    vdbfusion::HardwareCounters::Instance().Read(after);
+    const size_t dtlb = static_cast<size_t>(vdbfusion::Counter::kDTLBMisses);
+    return {static_cast<double>(n_leaves), seconds,
+            static_cast<double>(after[dtlb] - before[dtlb])};
+}
+
+Measurement MeshWorkload(const Sequence& sequence) {
+    vdbfusion::Mapper mapper(BaseConfig());
+    IntegrateSequence(mapper, sequence);
+    const auto volume = mapper.Snapshot()->ToVDBVolume();
+    const auto start = Clock::now();
+    const auto mesh = volume.ExtractTriangleMesh(true, 0.0f);
+    const double seconds = SecondsSince(start);
+    return {static_cast<double>(volume.tsdf_->activeVoxelCount()), seconds};
+}
+
+Measurement SaveWorkload(const Sequence& sequence) {
+    vdbfusion::Mapper mapper(BaseConfig());
+    IntegrateSequence(mapper, sequence);
+    const auto volume = mapper.Snapshot()->ToVDBVolume();
+    const double voxels = static_cast<double>(volume.tsdf_->activeVoxelCount());
+    const std::string prefix =
+        (std::filesystem::temp_directory_path() / "vdbfusion_ros_perf").string();
+    const auto start = Clock::now();
+    mapper.Save(prefix);
+    const double seconds = SecondsSince(start);
+    std::filesystem::remove(prefix + "_grid.vdb");
+    std::filesystem::remove(prefix + "_mesh.ply");
+    return {voxels, seconds};
+}
+
+// 100 Hz odometry, every scan falls between two poses and is interpolated
+Measurement PoseLookupWorkload(int n_poses) {
+    const vdbfusion::SyntheticScene scene;
+    std::vector<geometry_msgs::TransformStamped> poses(n_poses);
+    for (int i = 0; i < n_poses; ++i) {
+        poses[i].header.stamp = ros::Time(1.0 + 0.01 * i);
+        poses[i].transform = SE3ToTransform(vdbfusion::CorridorPose(scene, 0.01 * i, 2.0));
+    }
+    vdbfusion::PoseBuffer buffer;
+    geometry_msgs::TransformStamped transform;
+    const ros::Duration tolerance(0, 1000);
+    size_t found = 0;
+    const auto start = Clock::now();
+    for (int i = 0; i < n_poses; ++i) {
+        buffer.Add(poses[i]);
+        found += buffer.Lookup(ros::Time(1.0 + 0.01 * i - 0.005), tolerance, transform);
+    }
+    return {static_cast<double>(found), SecondsSince(start)};
+}
+
+void WriteReport(const std::string& filename,
+                 const Options& options,
+                 const std::vector<WorkloadResult>& results) {
+    std::ofstream out(filename);
+    out << "{\n  \"scans\": " << options.scans << ",\n  \"workloads\": {\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& result = results[i];
+        out << "    \"" << result.name << "\": {\"unit\": \"" << result.unit
+            << "\", \"throughput\": " << result.throughput << ", \"seconds\": " << result.seconds
+            << ", \"peak_rss_mb\": " << result.peak_rss_mb
+            << ", \"dtlb_misses\": " << result.dtlb_misses << "}"
+            << (i + 1 < results.size() ? ",\n" : "\n");
+    }
+    out << "  }\n}\n";
+}
+
+// Fused integration with 4^3, 8^3 and 16^3 voxel leaves
+void PrintLeafDimSweep(const std::vector<WorkloadResult>& results) {
+    const auto find = [&](const std::string& name) {
+        return *std::find_if(results.begin(), results.end(),
+                             [&](const auto& result) { return result.name == name; });
+    };
+    std::printf("\n%-24s %14s %12s %10s\n", "leaf_dim", "points/s", "peak MB", "dTLB/unit");
+    for (const auto& [leaf_dim, name] : {std::pair{4, "integrate_fused_leaf4"},
+                                         std::pair{8, "integrate_fused"},
+                                         std::pair{16, "integrate_fused_leaf16"}}) {
+        const auto& result = find(name);
+        std::printf("%-24d %14.1f %12.1f %10.4f\n", leaf_dim, result.throughput,
+                    result.peak_rss_mb, result.dtlb_misses);
+    }
+}
+
+// The same workloads with the system allocator and with the leaf pool
+void PrintLeafPoolComparison(const std::vector<WorkloadResult>& results) {
+    const auto find = [&](const std::string& name) {
+        return *std::find_if(results.begin(), results.end(),
+                             [&](const auto& result) { return result.name == name; });
+    };
+    std::printf("\n%-24s %14s %14s %12s %12s\n", "leaf pool", "system", "pool", "system MB",
+                "pool MB");
+    for (const std::string name : {"leaf_allocation", "integrate_raycast"}) {
+        const auto& system = find(name);
+        const auto& pooled = find(name + "_pool");
+        std::printf("%-24s %14.1f %14.1f %12.1f %12.1f  %s\n", name.c_str(), system.throughput,
+                    pooled.throughput, system.peak_rss_mb, pooled.peak_rss_mb, system.unit.c_str());
+        std::printf("%-24s %14.4f %14.4f\n", "  dTLB misses per unit", system.dtlb_misses,
+                    pooled.dtlb_misses);
+    }
+    const auto stats = vdbfusion::LeafPool::Instance().Stats();
+    std::printf("pool refills took %.3f s for %zu allocations in %zu slabs\n", stats.refill_seconds,
+                stats.allocations, stats.slabs);
+}
+
+struct NamedWorkload {
+    std::string name;
+    std::string unit;
+    std::function<Measurement()> run;
+    // Runs with the leaf pool, which can not be turned off again once enabled
+    bool leaf_pool = false;
+};
+
+enum class Comparison { kPassed, kRegressed, kMissingBaseline };
+
+// A key of the workload in the tolerance config, else the key of the config, else fallback
+double Tolerance(const YAML::Node& tolerances,
+                 const std::string& workload,
+                 const std::string& key,
+                 double fallback) {
+    if (!tolerances.IsMap()) {
+        return fallback;
+    }
+    if (const YAML::Node workloads = tolerances["workloads"]) {
+        if (const YAML::Node overrides = workloads[workload]) {
+            if (const YAML::Node value = overrides[key]) {
+                return value.as<double>();
+            }
+        }
+    }
+    if (const YAML::Node value = tolerances[key]) {
+        return value.as<double>();
+    }
+    return fallback;
+}
+
+// Baseline values are null until they are recorded
+bool Recorded(const YAML::Node& reference, const char* key) {
+    if (!reference) {
+        return false;
+    }
+    const YAML::Node value = reference[key];
+    return value && value.IsScalar();
+}
+
+// JSON is read as YAML. The tolerance config replaces --tolerance and --memory_tolerance and may
+// override them per workload.
+Comparison CheckBaseline(const Options& options, const std::vector<WorkloadResult>& results) {
+    const YAML::Node baseline = YAML::LoadFile(options.baseline);
+    const YAML::Node tolerances =
+        options.tolerances.empty() ? YAML::Node() : YAML::LoadFile(options.tolerances);
+    if (baseline["scans"] && baseline["scans"].IsScalar() &&
+        baseline["scans"].as<int>() != options.scans) {
+        std::cerr << "The baseline was recorded with " << baseline["scans"].as<int>()
+                  << " scans, this run uses " << options.scans << "\n";
+    }
+    const YAML::Node workloads = baseline["workloads"];
+    bool passed = true;
+    bool missing = false;
+    std::printf("\n%-22s %10s %10s  %s\n", "workload", "speed", "memory", "status");
+    for (const auto& result : results) {
+        const YAML::Node reference = workloads ? workloads[result.name] : YAML::Node();
+        if (!Recorded(reference, "throughput") || !Recorded(reference, "peak_rss_mb")) {
+            std::printf("%-22s %10s %10s  NO BASELINE\n", result.name.c_str(), "-", "-");
+            missing = true;
+            continue;
+        }
+        const double tolerance =
+            Tolerance(tolerances, result.name, "tolerance", options.tolerance);
+        const double memory_tolerance =
+            Tolerance(tolerances, result.name, "memory_tolerance", options.memory_tolerance);
+        const double speedup =
+            100.0 * (result.throughput / reference["throughput"].as<double>() - 1.0);
+        const double growth =
+            100.0 * (result.peak_rss_mb / reference["peak_rss_mb"].as<double>() - 1.0);
+        const bool regressed = -speedup > tolerance || growth > memory_tolerance;
+        passed = passed && !regressed;
+        std::printf("%-22s %+9.1f%% %+9.1f%%  %s\n", result.name.c_str(), speedup, growth,
+                    regressed ? "REGRESSION" : "ok");
+    }
+    if (!passed) {
+        return Comparison::kRegressed;
+    }
+    if (missing) {
+        std::cerr << "Record the baseline on the reference machine with --output "
+                  << options.baseline << "\n";
+        return Comparison::kMissingBaseline;
+    }
+    return Comparison::kPassed;
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--scans" && i + 1 < argc) {
+            options.scans = std::atoi(argv[++i]);
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            options.repeat = std::atoi(argv[++i]);
+        } else if (arg == "--workload" && i + 1 < argc) {
+            options.workload = argv[++i];
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--baseline" && i + 1 < argc) {
+            options.baseline = argv[++i];
+        } else if (arg == "--tolerances" && i + 1 < argc) {
+            options.tolerances = argv[++i];
+        } else if (arg == "--tolerance" && i + 1 < argc) {
+            options.tolerance = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--memory_tolerance" && i + 1 < argc) {
+            options.memory_tolerance = std::strtod(argv[++i], nullptr);
+        } else {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (options.scans < 1 || options.repeat < 1) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    // The per-scan messages of the mapper would dominate the output
+    if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn)) {
+        ros::console::notifyLoggerLevelsChanged();
+    }
+
+    // The dTLB misses are only reported where the kernel lets the process count them
+    const bool counters = vdbfusion::HardwareCounters::Instance().Enable();
+    if (!counters) {
+        std::cerr << "Hardware counters are not available, the dTLB misses read 0\n";
+    }
+
+    const vdbfusion::SyntheticSensor sensor;
+    const Sequence sequence = RenderSequence(sensor, options.scans);
+
+    // The leaf_dim sweep, integrate_fused keeps the default 8^3 voxel leaves
+    const auto fused = [](int leaf_dim) {
+        auto config = BaseConfig();
+        config.fused_layout = true;
+        config.leaf_dim = leaf_dim;
+        config.batch_scans = 4;
+        return config;
+    };
+    auto pool_config = BaseConfig();
+    pool_config.leaf_pool = true;
+    pool_config.leaf_pool_reserve_bytes = size_t(8) << 30;
+    // The leaf pool workloads come last, the pool stays enabled for the rest of the process
+    const std::vector<NamedWorkload> workloads = {
+        {"integrate_raycast", "points/s",
+         [&] { return IntegrationWorkload(BaseConfig(), sequence); }},
+        {"integrate_packets", "points/s",
+         [&] {
+             auto config = BaseConfig();
+             config.ray_packets = true;
+             config.batch_scans = 4;
+             return IntegrationWorkload(config, sequence);
+         }},
+        {"integrate_fused", "points/s", [&] { return IntegrationWorkload(fused(8), sequence); }},
+        {"integrate_fused_leaf4", "points/s",
+         [&] { return IntegrationWorkload(fused(4), sequence); }},
+        {"integrate_fused_leaf16", "points/s",
+         [&] { return IntegrationWorkload(fused(16), sequence); }},
+        {"integrate_projective", "points/s",
+         [&] {
+             auto config = BaseConfig();
+             config.projective = true;
+             config.lidar = {sensor.rows, sensor.columns, sensor.fov_up, sensor.fov_down, {}};
+             return IntegrationWorkload(config, sequence);
+         }},
+        {"integrate_beams", "points/s",
+         [&] {
+             auto config = BaseConfig();
+             config.beam_model = true;
+             config.beam_model_learning_scans = 1;
+             return IntegrationWorkload(config, sequence, 1);
+         }},
+        {"mesh", "voxels/s", [&] { return MeshWorkload(sequence); }},
+        {"save", "voxels/s", [&] { return SaveWorkload(sequence); }},
+        {"pose_lookup", "lookups/s", [&] { return PoseLookupWorkload(100000); }},
+        {"leaf_allocation", "leaves/s", [&] { return LeafAllocationWorkload(kLeafAllocations); }},
+        {"leaf_allocation_pool", "leaves/s",
+         [&] { return LeafAllocationWorkload(kLeafAllocations); }, true},
+        {"integrate_raycast_pool", "points/s",
+         [&] { return IntegrationWorkload(pool_config, sequence); }, true},
+    };
+    if (!options.workload.empty() &&
+        std::none_of(workloads.begin(), workloads.end(),
+                     [&](const auto& workload) { return workload.name == options.workload; })) {
+        std::cerr << "Unknown workload " << options.workload << "\n";
+        PrintUsage(argv[0]);
+        return 2;
+    }
+
+    std::vector<WorkloadResult> results;
+    bool leaf_pool = false;
+    for (const auto& workload : workloads) {
+        if (!options.workload.empty() && workload.name != options.workload) {
+            continue;
+        }
+        if (workload.leaf_pool && !leaf_pool) {
+            leaf_pool = vdbfusion::LeafPool::Instance().Enable(pool_config.leaf_pool_reserve_bytes,
+                                                               pool_config.leaf_pool_huge_pages);
+            if (!leaf_pool) {
+                std::cerr << "Could not enable the leaf pool, skipping the pool workloads\n";
+                break;
+            }
+        }
+        results.push_back(Run(workload.name, workload.unit, options.repeat, workload.run));
+    }
+    if (options.workload.empty()) {
+        PrintLeafDimSweep(results);
+    }
+    if (options.workload.empty() && leaf_pool) {
+        PrintLeafPoolComparison(results);
+    }
+
+    if (!options.output.empty()) {
+        WriteReport(options.output, options, results);
+    }
+    if (options.baseline.empty()) {
+        return 0;
+    }
+    switch (CheckBaseline(options, results)) {
+        case Comparison::kPassed:
+            return 0;
+        case Comparison::kRegressed:
+            return 1;
+        case Comparison::kMissingBaseline:
+            return kMissingBaseline;
+    }
+    return 0;
+}
@@ -0,0 +1,114 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PipelineStats.hpp"
+
+#include <chrono>
+#include <cstdio>
+#include <string>
+
+#include "HardwareCounters.hpp"
+
+namespace {
+double Count(const vdbfusion::StageStats& stats, vdbfusion::Counter counter) {
+    return static_cast<double>(stats.counters[static_cast<size_t>(counter)]);
+}
+}  // namespace
+
+const char* vdbfusion::StageName(Stage stage) {
+    switch (stage) {
+        case Stage::kDecode:
+            return "decode";
+        case Stage::kFilter:
+            return "filter";
+        case Stage::kTransform:
+            return "transform";
+        case Stage::kIntegrate:
+            return "integrate";
+        case Stage::kDeintegrate:
+            return "deintegrate";
+    }
+    return "unknown";
+}
+
+std::string vdbfusion::FormatSummary(const PipelineStats& stats) {
+    const auto& counters = HardwareCounters::Instance();
+    const bool with_counters = counters.Enabled();
+    std::string summary;
+    char line[256];
+    std::snprintf(line, sizeof(line), "%-12s %10s %12s", "stage", "calls", "ms/call");
+    summary += line;
+    if (with_counters) {
+        std::snprintf(line, sizeof(line), " %14s %6s %10s %10s %10s", "instructions", "IPC",
+                      "LLC/ki", "dTLB/ki", "branch/ki");
+        summary += line;
+    }
+    for (size_t i = 0; i < kStageCount; ++i) {
+        const auto stage = static_cast<Stage>(i);
+        const auto& stage_stats = stats[stage];
+        const double ms = stage_stats.calls ? 1e3 * stage_stats.seconds / stage_stats.calls : 0.0;
+        std::snprintf(line, sizeof(line), "\n%-12s %10zu %12.3f", StageName(stage),
+                      stage_stats.calls, ms);
+        summary += line;
+        if (!with_counters) {
+            continue;
+        }
+        const double cycles = Count(stage_stats, Counter::kCycles);
+        const double instructions = Count(stage_stats, Counter::kInstructions);
+        std::snprintf(line, sizeof(line), " %14.0f %6.2f", instructions,
+                      cycles > 0.0 ? instructions / cycles : 0.0);
+        summary += line;
+        for (const auto counter :
+             {Counter::kLLCMisses, Counter::kDTLBMisses, Counter::kBranchMisses}) {
+            if (counters.Available(counter)) {
+                const double misses = Count(stage_stats, counter);
+                std::snprintf(line, sizeof(line), " %10.3f",
+                              instructions > 0.0 ? 1e3 * misses / instructions : 0.0);
+            } else {
+                std::snprintf(line, sizeof(line), " %10s", "n/a");
+            }
+            summary += line;
+        }
+    }
+    return summary;
+}
+
+vdbfusion::ScopedStage::ScopedStage(PipelineStats& stats, Stage stage)
+    : stats_(stats),
+      stage_(stage),
+      counting_(HardwareCounters::Instance().Read(start_counters_)),
+      start_(std::chrono::steady_clock::now()) {}
+
+vdbfusion::ScopedStage::~ScopedStage() {
+    const double seconds =
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    CounterValues counters;
+    if (!counting_ || !HardwareCounters::Instance().Read(counters)) {
+        stats_.Add(stage_, seconds);
+        return;
+    }
+    for (size_t i = 0; i < kCounterCount; ++i) {
+        // Clamped in case reading one of the threads failed
+        counters[i] = counters[i] > start_counters_[i] ? counters[i] - start_counters_[i] : 0;
+    }
+    stats_.Add(stage_, seconds, &counters);
+}
@@ -0,0 +1,131 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "PoseBuffer.hpp"
+
+#include <geometry_msgs/Transform.h>
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/console.h>
+#include <ros/time.h>
+
+#include <deque>
+#include <mutex>
+
+#include "ParamSource.hpp"
+#include "sophus/se3.hpp"
+
+using geometry_msgs::Transform;
+using geometry_msgs::TransformStamped;
+
+namespace {
+Transform Interpolate(const Transform& tf_old, const Transform& tf_new, const double alpha) {
+    auto T_old = TransformToSE3(tf_old);
+    auto T_new = TransformToSE3(tf_new);
+    return SE3ToTransform(T_old * Sophus::SE3d::exp(alpha * ((T_old.inverse() * T_new).log())));
+}
+}  // namespace
+
+void vdbfusion::PoseBuffer::SetStaticTransform(const Transform& static_tf) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    static_tf_ = static_tf;
+}
+
+void vdbfusion::PoseBuffer::Add(const TransformStamped& transform) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back(transform);
+}
+
+size_t vdbfusion::PoseBuffer::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return queue_.size();
+}
+
+bool vdbfusion::PoseBuffer::Lookup(const ros::Time& timestamp,
+                                   const ros::Duration& tolerance,
+                                   TransformStamped& transform) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (queue_.empty()) {
+        ROS_WARN_STREAM_THROTTLE(30, "No match found for transform timestamp: "
+                                         << timestamp << " as transform queue is empty.");
+        return false;
+    }
+    bool match_found = false;
+    auto it = queue_.begin();
+    for (; it != queue_.end(); ++it) {
+        if (it->header.stamp > timestamp) {
+            if ((it->header.stamp - timestamp).toNSec() < tolerance.toNSec()) {
+                match_found = true;
+            }
+            break;
+        }
+
+        if ((timestamp - it->header.stamp).toNSec() < tolerance.toNSec()) {
+            match_found = true;
+            break;
+        }
+    }
+
+    if (match_found) {
+        transform = *it;
+    } else {
+        if (it == queue_.begin() || it == queue_.end()) {
+            ROS_WARN_STREAM_THROTTLE(30, "No match found for transform timestamp: " << timestamp);
+            return false;
+        }
+        TransformStamped tf_newest = *it;
+        int64_t newest_timestamp_ns = it->header.stamp.toNSec();
+        --it;
+        TransformStamped tf_oldest = *it;
+        int64_t oldest_timestamp_ns = it->header.stamp.toNSec();
+
+        double alpha = 0.0;
+        if (newest_timestamp_ns != oldest_timestamp_ns) {
+            alpha = static_cast<double>(timestamp.toNSec() - oldest_timestamp_ns) /
+                    static_cast<double>(newest_timestamp_ns - oldest_timestamp_ns);
+        }
+        transform.transform = Interpolate(tf_oldest.transform, tf_newest.transform, alpha);
+    }
+
+    transform.transform = SE3ToTransform(TransformToSE3(transform.transform) *
+                                         (TransformToSE3(static_tf_).inverse()));
+
+    queue_.erase(queue_.begin(), it);
+    return true;
+}
+
+geometry_msgs::Transform vdbfusion::ReadStaticTransform(const ParamSource& params) {
+    geometry_msgs::Transform static_tf = SE3ToTransform(Sophus::SE3d());
+    params.Get("tx", static_tf.translation.x);
+    params.Get("ty", static_tf.translation.y);
+    params.Get("tz", static_tf.translation.z);
+    params.Get("x", static_tf.rotation.x);
+    params.Get("y", static_tf.rotation.y);
+    params.Get("z", static_tf.rotation.z);
+    params.Get("w", static_tf.rotation.w);
+
+    bool invert_static_tf = false;
+    params.Get("invert_static_tf", invert_static_tf);
+    if (invert_static_tf) {
+        static_tf = SE3ToTransform(TransformToSE3(static_tf).inverse());
+    }
+    return static_tf;
+}
@@ -0,0 +1,247 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RangeImage.hpp"
+
+#include <openvdb/math/DDA.h>
+#include <openvdb/math/Ray.h>
+#include <openvdb/openvdb.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "sophus/se3.hpp"
+
+namespace {
+std::vector<float> BeamElevations(const vdbfusion::LiDARIntrinsics& intrinsics) {
+    if (!intrinsics.beam_elevations.empty()) {
+        auto elevations = intrinsics.beam_elevations;
+        std::sort(elevations.begin(), elevations.end());
+        return elevations;
+    }
+    std::vector<float> elevations(intrinsics.rings, intrinsics.fov_down);
+    if (intrinsics.rings > 1) {
+        const float step = (intrinsics.fov_up - intrinsics.fov_down) / (intrinsics.rings - 1);
+        for (int ring = 0; ring < intrinsics.rings; ++ring) {
+            elevations[ring] = intrinsics.fov_down + ring * step;
+        }
+    }
+    return elevations;
+}
+}  // namespace
+
+vdbfusion::RangeImage::RangeImage(const LiDARIntrinsics& intrinsics)
+    : cols_(intrinsics.azimuth_bins) {
+    const auto elevations = BeamElevations(intrinsics);
+    rings_ = static_cast<int>(elevations.size());
+
+    // Each ring owns the elevations up to half way to its neighbours, the LUT resolution is
+    // chosen fine enough to resolve the narrowest gap between two beams
+    float min_gap = rings_ > 1 ? elevations[1] - elevations[0] : 0.01f;
+    for (int ring = 1; ring < rings_; ++ring) {
+        min_gap = std::min(min_gap, elevations[ring] - elevations[ring - 1]);
+    }
+    min_gap = std::max(min_gap, 1e-5f);
+    const float resolution = min_gap / 8.0f;
+    lut_min_elevation_ = elevations.front() - min_gap / 2.0f;
+    lut_inv_resolution_ = 1.0f / resolution;
+    const float lut_max_elevation = elevations.back() + min_gap / 2.0f;
+    const float lut_span = lut_max_elevation - lut_min_elevation_;
+    const auto lut_size = static_cast<size_t>(std::ceil(lut_span * lut_inv_resolution_));
+
+    elevation_lut_.resize(lut_size);
+    int ring = 0;
+    for (size_t bin = 0; bin < lut_size; ++bin) {
+        const float elevation = lut_min_elevation_ + (static_cast<float>(bin) + 0.5f) * resolution;
+        while (ring + 1 < rings_ && std::abs(elevations[ring + 1] - elevation) <
+                                        std::abs(elevations[ring] - elevation)) {
+            ++ring;
+        }
+        elevation_lut_[bin] = static_cast<int16_t>(ring);
+    }
+
+    ranges_.resize(rings_ * cols_, 0.0f);
+    points_.resize(rings_ * cols_, Eigen::Vector3f::Zero());
+    valid_pixels_.reserve(rings_ * cols_);
+}
+
+int vdbfusion::RangeImage::RingFromElevation(float elevation) const {
+    const float bin = (elevation - lut_min_elevation_) * lut_inv_resolution_;
+    if (bin < 0.0f || bin >= static_cast<float>(elevation_lut_.size())) {
+        return -1;
+    }
+    return elevation_lut_[static_cast<size_t>(bin)];
+}
+
+int vdbfusion::RangeImage::Project(const Eigen::Vector3f& point) const {
+    const float planar_range = std::hypot(point.x(), point.y());
+    if (planar_range == 0.0f && point.z() == 0.0f) {
+        return -1;
+    }
+    const int ring = RingFromElevation(std::atan2(point.z(), planar_range));
+    if (ring < 0) {
+        return -1;
+    }
+    const float azimuth = std::atan2(point.y(), point.x()) + static_cast<float>(M_PI);
+    const int col = std::min(static_cast<int>(azimuth * cols_ / (2.0f * static_cast<float>(M_PI))),
+                             cols_ - 1);
+    return ring * cols_ + col;
+}
+
+void vdbfusion::RangeImage::Build(const ScanBuffer& scan) {
+    std::fill(ranges_.begin(), ranges_.end(), 0.0f);
+    valid_pixels_.clear();
+    for (size_t i = 0; i < scan.size(); ++i) {
+        const Eigen::Vector3f p(scan.x[i], scan.y[i], scan.z[i]);
+        const int pixel = Project(p);
+        if (pixel < 0) {
+            continue;
+        }
+        // Keep the closest return per pixel, the first surface hit along the beam
+        const float range = p.norm();
+        if (ranges_[pixel] == 0.0f) {
+            valid_pixels_.emplace_back(pixel);
+        } else if (range >= ranges_[pixel]) {
+            continue;
+        }
+        ranges_[pixel] = range;
+        points_[pixel] = p;
+    }
+}
+
+void vdbfusion::IntegrateProjective(VDBVolume& volume,
+                                    const RangeImage& range_image,
+                                    const Sophus::SE3d& T_world_sensor,
+                                    const std::function<float(float)>& weighting_function,
+                                    ProjectiveScratch& scratch) {
+    using LeafT = openvdb::FloatTree::LeafNodeType;
+    const auto& valid_pixels = range_image.ValidPixels();
+    if (valid_pixels.empty()) {
+        return;
+    }
+
+    const openvdb::math::Transform& xform = volume.tsdf_->transform();
+    const float sdf_trunc = volume.sdf_trunc_;
+    const bool space_carving = volume.space_carving_;
+    const double voxel_size = xform.voxelSize()[0];
+    const int band = static_cast<int>(std::ceil(sdf_trunc / voxel_size));
+    const openvdb::Int32 leaf_mask = ~static_cast<openvdb::Int32>(LeafT::DIM - 1);
+    const Eigen::Vector3d origin = T_world_sensor.translation();
+    const openvdb::Vec3R eye(origin.x(), origin.y(), origin.z());
+
+    // Candidate leaves: every leaf overlapping the truncation band around an observed endpoint,
+    // plus the leaves crossed by the beam when carving free space.
+    auto& leaf_origins = scratch.leaf_origins;
+    leaf_origins.clear();
+    std::for_each(valid_pixels.cbegin(), valid_pixels.cend(), [&](const int pixel) {
+        const Eigen::Vector3d point = T_world_sensor * range_image.Point(pixel).cast<double>();
+        const openvdb::Coord ijk =
+            xform.worldToIndexCellCentered(openvdb::Vec3d(point.x(), point.y(), point.z()));
+        const openvdb::Coord min = ijk.offsetBy(-band);
+        const openvdb::Coord max = ijk.offsetBy(band);
+        for (openvdb::Int32 x = min.x() & leaf_mask; x <= max.x(); x += LeafT::DIM) {
+            for (openvdb::Int32 y = min.y() & leaf_mask; y <= max.y(); y += LeafT::DIM) {
+                for (openvdb::Int32 z = min.z() & leaf_mask; z <= max.z(); z += LeafT::DIM) {
+                    const openvdb::Coord leaf_origin(x, y, z);
+                    if (leaf_origins.empty() || leaf_origins.back() != leaf_origin) {
+                        leaf_origins.emplace_back(leaf_origin);
+                    }
+                }
+            }
+        }
+        if (space_carving) {
+            const Eigen::Vector3d direction = point - origin;
+            openvdb::Vec3R dir(direction.x(), direction.y(), direction.z());
+            dir.normalize();
+            const auto ray = openvdb::math::Ray<double>(eye, dir, 0.0, direction.norm())
+                                 .worldToIndex(*volume.tsdf_);
+            openvdb::math::DDA<decltype(ray), LeafT::TOTAL> dda(ray);
+            do {
+                leaf_origins.emplace_back(dda.voxel());
+            } while (dda.step());
+        }
+    });
+    std::sort(leaf_origins.begin(), leaf_origins.end());
+    leaf_origins.erase(std::unique(leaf_origins.begin(), leaf_origins.end()), leaf_origins.end());
+
+    // Topology changes are not thread safe, allocate all the candidate leaves upfront
+    auto& tsdf_tree = volume.tsdf_->tree();
+    auto& weights_tree = volume.weights_->tree();
+    const size_t n_leaves = leaf_origins.size();
+    auto& tsdf_leaves = scratch.tsdf_leaves;
+    auto& weights_leaves = scratch.weights_leaves;
+    auto& created = scratch.created;
+    tsdf_leaves.resize(n_leaves);
+    weights_leaves.resize(n_leaves);
+    created.resize(n_leaves);
+    for (size_t i = 0; i < n_leaves; ++i) {
+        created[i] = tsdf_tree.probeLeaf(leaf_origins[i]) == nullptr;
+        tsdf_leaves[i] = tsdf_tree.touchLeaf(leaf_origins[i]);
+        weights_leaves[i] = weights_tree.touchLeaf(leaf_origins[i]);
+    }
+
+    // Each leaf is owned by a single task, so every voxel is projected and updated exactly once
+    const Eigen::Matrix3d R_sensor_world = T_world_sensor.rotationMatrix().transpose();
+    auto& n_updates = scratch.n_updates;
+    n_updates.assign(n_leaves, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n_leaves), [&](const auto& range) {
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            LeafT* tsdf_leaf = tsdf_leaves[i];
+            LeafT* weights_leaf = weights_leaves[i];
+            for (openvdb::Index offset = 0; offset < LeafT::SIZE; ++offset) {
+                const openvdb::Coord voxel = tsdf_leaf->offsetToGlobalCoord(offset);
+                const openvdb::Vec3d center = xform.indexToWorld(voxel) + voxel_size / 2.0;
+                const Eigen::Vector3d voxel_center(center.x(), center.y(), center.z());
+                const Eigen::Vector3f p = (R_sensor_world * (voxel_center - origin)).cast<float>();
+                const int pixel = range_image.Project(p);
+                if (pixel < 0 || range_image.Range(pixel) == 0.0f) {
+                    continue;
+                }
+                const float sdf = range_image.Range(pixel) - p.norm();
+                if (sdf <= -sdf_trunc || (!space_carving && sdf >= sdf_trunc)) {
+                    continue;
+                }
+                const float tsdf = std::min(sdf_trunc, sdf);
+                const float weight = weighting_function(sdf);
+                const float last_weight = weights_leaf->getValue(offset);
+                const float last_tsdf = tsdf_leaf->getValue(offset);
+                const float new_weight = weight + last_weight;
+                const float new_tsdf = (last_tsdf * last_weight + tsdf * weight) / (new_weight);
+                tsdf_leaf->setValueOn(offset, new_tsdf);
+                weights_leaf->setValueOn(offset, new_weight);
+                ++n_updates[i];
+            }
+        }
+    });
+
+    // Drop the leaves we allocated but that did not receive a single measurement
+    for (size_t i = 0; i < n_leaves; ++i) {
+        if (created[i] && n_updates[i] == 0) {
+            delete tsdf_tree.stealNode<LeafT>(leaf_origins[i], tsdf_tree.background(), false);
+            delete weights_tree.stealNode<LeafT>(leaf_origins[i], weights_tree.background(), false);
+        }
+    }
+}
@@ -0,0 +1,321 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RayPackets.hpp"
+
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <vector>
+
+namespace {
+uint64_t LeafKey(const openvdb::Coord& voxel) {
+    constexpr int32_t kOffset = 1 << 20;
+    constexpr uint64_t kMask = (uint64_t(1) << 21) - 1;
+    const openvdb::Coord leaf = voxel >> openvdb::FloatTree::LeafNodeType::LOG2DIM;
+    return ((uint64_t(leaf.x() + kOffset) & kMask) << 42) |
+           ((uint64_t(leaf.y() + kOffset) & kMask) << 21) | (uint64_t(leaf.z() + kOffset) & kMask);
+}
+
+struct Band {
+    double voxel_size;
+    float sdf_trunc;
+    int max_steps;
+};
+
+// Correctly rounded square root of every lane. Eigen's fast math sqrt is an approximation on some
+// targets, which would make the distances depend on the packet width.
+template <int W>
+Eigen::Array<double, W, 1> Sqrt(const Eigen::Array<double, W, 1>& values) {
+    Eigen::Array<double, W, 1> result;
+    for (int l = 0; l < W; ++l) {
+        result[l] = std::sqrt(values[l]);
+    }
+    return result;
+}
+
+template <int W>
+struct PacketAxis {
+    using ArrayD = Eigen::Array<double, W, 1>;
+    ArrayD voxel;
+    ArrayD step;
+    ArrayD t_max;
+    ArrayD t_delta;
+
+    // Amanatides & Woo setup along one axis, t is kept in world units
+    PacketAxis(const ArrayD& direction, const ArrayD& t0, const ArrayD& eye, double voxel_size) {
+        constexpr double inf = std::numeric_limits<double>::infinity();
+        const ArrayD start = eye + (t0 / voxel_size) * direction;
+        const ArrayD forward = (direction > 0.0).template cast<double>();
+        voxel = start.floor();
+        step = forward - (direction < 0.0).template cast<double>();
+        t_max = (direction != 0.0)
+                    .select(t0 + (voxel + forward - start) * voxel_size / direction,
+                            ArrayD::Constant(inf));
+        t_delta =
+            (direction != 0.0).select(voxel_size / direction.abs(), ArrayD::Constant(inf));
+    }
+
+    void Advance(const ArrayD& picked) {
+        voxel += picked * step;
+        t_max = (picked > 0.0).select(t_max + t_delta, t_max);
+    }
+};
+
+// Traverses the truncation band of up to W rays and stores the visited voxels and their signed
+// distances in the scratch buffers. The lanes are Eigen arrays, so every operation is a packet
+// instruction on whatever SIMD width the target is compiled for, and the arithmetic of a lane
+// does not depend on W.
+template <int W>
+void TraversePacket(const Band& band,
+                    const vdbfusion::ScanBatch& batch,
+                    const vdbfusion::PacketRay* rays,
+                    int n_rays,
+                    vdbfusion::PacketScratch& scratch,
+                    int* n_steps) {
+    using ArrayD = Eigen::Array<double, W, 1>;
+    using ArrayF = Eigen::Array<float, W, 1>;
+    using ArrayI = Eigen::Array<int32_t, W, 1>;
+
+    // Inactive lanes replay the last ray and are never read back
+    ArrayD px, py, pz;
+    ArrayD ox, oy, oz;
+    ArrayD ex, ey, ez;
+    for (int l = 0; l < W; ++l) {
+        const auto& ray = rays[std::min(l, n_rays - 1)];
+        const auto& point = batch.points[ray.scan][ray.point];
+        const auto& origin = batch.origins[ray.scan];
+        const auto& eye = scratch.eyes[ray.scan];
+        px[l] = point.x();
+        py[l] = point.y();
+        pz[l] = point.z();
+        ox[l] = origin.x();
+        oy[l] = origin.y();
+        oz[l] = origin.z();
+        ex[l] = eye.x();
+        ey[l] = eye.y();
+        ez[l] = eye.z();
+    }
+    const ArrayD dx = px - ox;
+    const ArrayD dy = py - oy;
+    const ArrayD dz = pz - oz;
+    const ArrayD depth = Sqrt<W>(dx * dx + dy * dy + dz * dz);
+    const ArrayD t0 = depth - band.sdf_trunc;
+    const ArrayD t1 = depth + band.sdf_trunc;
+    PacketAxis<W> x(dx / depth, t0, ex, band.voxel_size);
+    PacketAxis<W> y(dy / depth, t0, ey, band.voxel_size);
+    PacketAxis<W> z(dz / depth, t0, ez, band.voxel_size);
+
+    const double half_voxel = band.voxel_size / 2.0;
+    ArrayD alive = ArrayD::Ones();
+    ArrayD steps = ArrayD::Zero();
+    for (int step = 0; step < band.max_steps; ++step) {
+        // Same voxel center and signed distance as VDBVolume::Integrate
+        const ArrayD cx = x.voxel * band.voxel_size + half_voxel;
+        const ArrayD cy = y.voxel * band.voxel_size + half_voxel;
+        const ArrayD cz = z.voxel * band.voxel_size + half_voxel;
+        const ArrayD qx = px - cx;
+        const ArrayD qy = py - cy;
+        const ArrayD qz = pz - cz;
+        const ArrayD dist = Sqrt<W>(qx * qx + qy * qy + qz * qz);
+        const ArrayD proj = (cx - ox) * qx + (cy - oy) * qy + (cz - oz) * qz;
+
+        // Dead lanes keep writing, their slots are past n_steps and never read back
+        const size_t slot = static_cast<size_t>(step) * W;
+        Eigen::Map<ArrayI>(scratch.vx.data() + slot) = x.voxel.template cast<int32_t>();
+        Eigen::Map<ArrayI>(scratch.vy.data() + slot) = y.voxel.template cast<int32_t>();
+        Eigen::Map<ArrayI>(scratch.vz.data() + slot) = z.voxel.template cast<int32_t>();
+        Eigen::Map<ArrayF>(scratch.sdf.data() + slot) =
+            (proj < 0.0).select(-dist, dist).template cast<float>();
+        steps += alive;
+
+        // Next voxel, ties are broken as in the scalar traversal
+        const ArrayD y_first = (y.t_max <= x.t_max).template cast<double>();
+        const ArrayD t_xy = (y_first > 0.0).select(y.t_max, x.t_max);
+        const ArrayD pick_z = (z.t_max <= t_xy).template cast<double>();
+        const ArrayD pick_y = (1.0 - pick_z) * y_first;
+        const ArrayD pick_x = 1.0 - pick_z - pick_y;
+        const ArrayD t_next = (pick_z > 0.0).select(z.t_max, t_xy);
+        alive *= (t_next <= t1).template cast<double>();
+        if (alive.sum() == 0.0) {
+            break;
+        }
+        x.Advance(pick_x);
+        y.Advance(pick_y);
+        z.Advance(pick_z);
+    }
+    for (int l = 0; l < W; ++l) {
+        n_steps[l] = static_cast<int>(steps[l]);
+    }
+}
+
+// vdbfusion's constant weighting, inlined into the update loop
+struct UnitWeight {
+    float operator()(float /*sdf*/) const { return 1.0f; }
+};
+
+// kRemove subtracts the contributions instead of adding them. Voxels left without weight are
+// switched off again with the background values, as if they had never been observed.
+template <int W, bool kRemove, typename Weighting>
+void UpdateOrdered(vdbfusion::VDBVolume& volume,
+                   const vdbfusion::ScanBatch& batch,
+                   const Band& band,
+                   const Weighting& weighting_function,
+                   vdbfusion::PacketScratch& scratch) {
+    const size_t slots = static_cast<size_t>(W) * band.max_steps;
+    scratch.vx.resize(slots);
+    scratch.vy.resize(slots);
+    scratch.vz.resize(slots);
+    scratch.sdf.resize(slots);
+    auto tsdf_acc = volume.tsdf_->getUnsafeAccessor();
+    auto weights_acc = volume.weights_->getUnsafeAccessor();
+    const float sdf_trunc = band.sdf_trunc;
+    const float background = volume.tsdf_->background();
+    int n_steps[W];
+    const auto n_rays = static_cast<int>(scratch.order.size());
+    for (int first = 0; first < n_rays; first += W) {
+        const int lanes = std::min(W, n_rays - first);
+        TraversePacket<W>(band, batch, scratch.order.data() + first, lanes, scratch, n_steps);
+        // Updates in ray order, the grids do not depend on the packet width
+        for (int l = 0; l < lanes; ++l) {
+            for (int step = 0; step < n_steps[l]; ++step) {
+                const size_t slot = static_cast<size_t>(step) * W + l;
+                const float sdf = scratch.sdf[slot];
+                if (sdf > -sdf_trunc) {
+                    const openvdb::Coord voxel(scratch.vx[slot], scratch.vy[slot],
+                                               scratch.vz[slot]);
+                    const float tsdf = std::min(sdf_trunc, sdf);
+                    const float weight = weighting_function(sdf);
+                    const float last_weight = weights_acc.getValue(voxel);
+                    const float last_tsdf = tsdf_acc.getValue(voxel);
+                    if constexpr (kRemove) {
+                        const float new_weight = last_weight - weight;
+                        if (new_weight <= 0.0f) {
+                            tsdf_acc.setValueOff(voxel, background);
+                            weights_acc.setValueOff(voxel, 0.0f);
+                            continue;
+                        }
+                        const float new_tsdf =
+                            (last_tsdf * last_weight - tsdf * weight) / new_weight;
+                        tsdf_acc.setValue(voxel, new_tsdf);
+                        weights_acc.setValue(voxel, new_weight);
+                        continue;
+                    }
+                    const float new_weight = weight + last_weight;
+                    const float new_tsdf = (last_tsdf * last_weight + tsdf * weight) / (new_weight);
+                    tsdf_acc.setValue(voxel, new_tsdf);
+                    weights_acc.setValue(voxel, new_weight);
+                }
+            }
+        }
+    }
+}
+
+template <bool kRemove, typename Weighting>
+void UpdatePackets(vdbfusion::VDBVolume& volume,
+                   const vdbfusion::ScanBatch& batch,
+                   const Weighting& weighting_function,
+                   vdbfusion::PacketScratch& scratch,
+                   int packet_width) {
+    const openvdb::math::Transform& xform = volume.tsdf_->transform();
+    Band band;
+    band.voxel_size = xform.voxelSize()[0];
+    band.sdf_trunc = volume.sdf_trunc_;
+    // A segment of length 2 * sdf_trunc crosses at most ceil(2 * sdf_trunc / voxel_size) + 1 voxel
+    // faces along each axis
+    band.max_steps =
+        3 * (static_cast<int>(std::ceil(2.0 * band.sdf_trunc / band.voxel_size)) + 1) + 1;
+
+    scratch.order.clear();
+    scratch.eyes.resize(batch.size());
+    for (size_t scan = 0; scan < batch.size(); ++scan) {
+        const auto& origin = batch.origins[scan];
+        const openvdb::Vec3d eye =
+            xform.worldToIndex(openvdb::Vec3d(origin.x(), origin.y(), origin.z()));
+        scratch.eyes[scan] = Eigen::Vector3d(eye.x(), eye.y(), eye.z());
+        const auto& points = batch.points[scan];
+        for (size_t i = 0; i < points.size(); ++i) {
+            const auto& point = points[i];
+            const openvdb::Coord voxel =
+                xform.worldToIndexCellCentered(openvdb::Vec3d(point.x(), point.y(), point.z()));
+            scratch.order.push_back(
+                {LeafKey(voxel), static_cast<uint32_t>(scan), static_cast<uint32_t>(i)});
+        }
+    }
+    if (scratch.order.empty()) {
+        return;
+    }
+    std::sort(scratch.order.begin(), scratch.order.end());
+
+    if (packet_width == 1) {
+        UpdateOrdered<1, kRemove>(volume, batch, band, weighting_function, scratch);
+    } else {
+        UpdateOrdered<vdbfusion::kPacketWidth, kRemove>(volume, batch, band, weighting_function,
+                                                        scratch);
+    }
+}
+}  // namespace
+
+void vdbfusion::IntegratePackets(VDBVolume& volume,
+                                 const ScanBatch& batch,
+                                 const std::function<float(float)>& weighting_function,
+                                 PacketScratch& scratch,
+                                 int packet_width) {
+    if (volume.space_carving_) {
+        for (size_t scan = 0; scan < batch.size(); ++scan) {
+            volume.Integrate(batch.points[scan], batch.origins[scan], weighting_function);
+        }
+        return;
+    }
+    UpdatePackets<false>(volume, batch, weighting_function, scratch, packet_width);
+}
+
+void vdbfusion::IntegratePackets(VDBVolume& volume,
+                                 const ScanBatch& batch,
+                                 PacketScratch& scratch,
+                                 int packet_width) {
+    if (volume.space_carving_) {
+        for (size_t scan = 0; scan < batch.size(); ++scan) {
+            volume.Integrate(batch.points[scan], batch.origins[scan], UnitWeight());
+        }
+        return;
+    }
+    UpdatePackets<false>(volume, batch, UnitWeight(), scratch, packet_width);
+}
+
+void vdbfusion::DeintegratePackets(VDBVolume& volume,
+                                   const ScanBatch& batch,
+                                   const std::function<float(float)>& weighting_function,
+                                   PacketScratch& scratch) {
+    UpdatePackets<true>(volume, batch, weighting_function, scratch, kPacketWidth);
+}
+
+void vdbfusion::DeintegratePackets(VDBVolume& volume,
+                                   const ScanBatch& batch,
+                                   PacketScratch& scratch) {
+    UpdatePackets<true>(volume, batch, UnitWeight(), scratch, kPacketWidth);
+}
@@ -0,0 +1,613 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/console.h>
+#include <ros/time.h>
+#include <rosbag/bag.h>
+#include <rosbag/view.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <tf2/buffer_core.h>
+#include <tf2/exceptions.h>
+#include <tf2_msgs/TFMessage.h>
+#include <yaml-cpp/yaml.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "LeafPool.hpp"
+#include "Mapper.hpp"
+#include "MapperMsgs.hpp"
+#include "MapperParams.hpp"
+#include "ParamSource.hpp"
+#include "PipelineStats.hpp"
+#include "PoseBuffer.hpp"
+#include "SyntheticScans.hpp"
+#include "VolumeComparison.hpp"
+#include "sophus/se3.hpp"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--scans <int>] [--output_dir <dir>] [--keep_output] [--hardware_counters]"
+                 " [--integration_mode <mode>] [--compare_raycast] [--bag <file.bag>]"
+                 " <config.yaml>...\n"
+              << "Replays every dataset through pose lookup, decoding, filtering, integration and "
+                 "saving, and writes <output_dir>/<config name>.json.\n"
+              << "A --bag applies to the config that follows it, configs without one are fed "
+                 "synthetic scans shaped after their sensor. --scans limits the bags and sets the "
+                 "length of the synthetic sequences (100). --hardware_counters adds the per-stage "
+                 "hardware counters to the reports where the kernel allows it. --integration_mode "
+                 "replaces the one of every config. --compare_raycast "
+                 "replays the configs with projective or beam model integration a second time "
+                 "with plain raycasting, writes <config name>_raycast.json and adds the speedup "
+                 "and the voxel and mesh differences to the report.\n";
+}
+
+double SecondsSince(Clock::time_point start) {
+    return std::chrono::duration<double>(Clock::now() - start).count();
+}
+
+// The flat parameters of config/*.yaml, read without the parameter server
+class YamlParams : public vdbfusion::ParamSource {
+public:
+    explicit YamlParams(const std::string& filename) : root_(YAML::LoadFile(filename)) {}
+
+    // Replaces the value of the file, e.g. from the command line
+    void Override(const std::string& name, const std::string& value) { root_[name] = value; }
+
+    bool Get(const std::string& name, bool& value) const override { return Read(name, value); }
+    bool Get(const std::string& name, int& value) const override { return Read(name, value); }
+    bool Get(const std::string& name, float& value) const override { return Read(name, value); }
+    bool Get(const std::string& name, double& value) const override { return Read(name, value); }
+    bool Get(const std::string& name, std::string& value) const override {
+        return Read(name, value);
+    }
+    bool Get(const std::string& name, std::vector<float>& value) const override {
+        return Read(name, value);
+    }
+    bool Get(const std::string& name, std::vector<std::vector<float>>& value) const override {
+        const YAML::Node list = root_[name];
+        if (!list || !list.IsSequence()) {
+            return false;
+        }
+        value.clear();
+        for (size_t i = 0; i < list.size(); ++i) {
+            std::vector<float> numbers;
+            try {
+                numbers = list[i].as<std::vector<float>>();
+            } catch (const YAML::Exception&) {
+                ROS_WARN_STREAM("Ignoring " << name << "[" << i << "], expected numbers");
+                continue;
+            }
+            value.push_back(std::move(numbers));
+        }
+        return true;
+    }
+
+private:
+    template <typename T>
+    bool Read(const std::string& name, T& value) const {
+        const YAML::Node node = root_[name];
+        if (!node) {
+            return false;
+        }
+        try {
+            value = node.as<T>();
+        } catch (const YAML::Exception&) {
+            return false;
+        }
+        return true;
+    }
+
+    YAML::Node root_;
+};
+
+struct ReplayReport {
+    std::string dataset;
+    std::string config;
+    std::string source;
+    size_t scans = 0;
+    size_t skipped_scans = 0;
+    double points = 0.0;
+    // Pose lookup and Mapper::Integrate of every scan
+    std::vector<double> latencies;
+    double replay_seconds = 0.0;
+    double pose_lookup_seconds = 0.0;
+    double save_seconds = 0.0;
+    vdbfusion::PipelineStats stages;
+    bool hardware_counters = false;
+    size_t active_voxels = 0;
+    double peak_rss_mb = 0.0;
+    // Final map: leaves and memory of the grids, and the marching cubes on its own
+    size_t leaves = 0;
+    double grid_mb = 0.0;
+    double mesh_seconds = 0.0;
+    // Eviction passes, run every eviction_period of sensor time
+    bool eviction = false;
+    size_t evicted_leaves = 0;
+    double eviction_seconds = 0.0;
+    // Against the same scans integrated by raycasting, with --compare_raycast
+    std::optional<vdbfusion::VolumeComparison> raycast;
+    double raycast_points_per_second = 0.0;
+};
+
+using PoseLookup = std::function<bool(const ros::Time&, geometry_msgs::TransformStamped&)>;
+
+// What the node does with a scan, timed scan by scan
+class Replayer {
+public:
+    Replayer(const vdbfusion::MapperConfig& config, ReplayReport& report)
+        : mapper_(config), report_(report) {}
+
+    const vdbfusion::MapperConfig& config() const { return mapper_.config(); }
+
+    void Integrate(const sensor_msgs::PointCloud2& pcd, const PoseLookup& lookup) {
+        const auto start = Clock::now();
+        geometry_msgs::TransformStamped transform;
+        const bool found = lookup(pcd.header.stamp, transform);
+        report_.pose_lookup_seconds += SecondsSince(start);
+        if (!found) {
+            ++report_.skipped_scans;
+            return;
+        }
+        vdbfusion::IntegrateCloud(mapper_, pcd, TransformToSE3(transform.transform));
+        const double latency = SecondsSince(start);
+        report_.latencies.push_back(latency);
+        report_.replay_seconds += latency;
+        report_.points += static_cast<double>(pcd.width) * pcd.height;
+        ++report_.scans;
+
+        // The passes the node would run on its timer, in sensor time
+        const double stamp = pcd.header.stamp.toSec();
+        if (!config().eviction) {
+            return;
+        }
+        if (last_eviction_ == 0.0) {
+            last_eviction_ = stamp;
+        } else if (stamp - last_eviction_ >= config().eviction_period) {
+            const auto eviction_start = Clock::now();
+            report_.evicted_leaves += mapper_.EvictTransients(stamp).evicted_leaves;
+            report_.eviction_seconds += SecondsSince(eviction_start);
+            last_eviction_ = stamp;
+        }
+    }
+
+    // Returns the final map
+    vdbfusion::VDBVolume Finish(const std::string& prefix, bool keep_output) {
+        auto start = Clock::now();
+        mapper_.Flush();
+        report_.replay_seconds += SecondsSince(start);
+        report_.stages = mapper_.Stats();
+
+        start = Clock::now();
+        mapper_.Save(prefix);
+        report_.save_seconds = SecondsSince(start);
+        const auto volume = mapper_.Snapshot()->ToVDBVolume();
+        report_.active_voxels = volume.tsdf_->activeVoxelCount();
+        report_.leaves = volume.weights_->tree().leafCount();
+        report_.grid_mb =
+            static_cast<double>(volume.tsdf_->memUsage() + volume.weights_->memUsage()) / (1 << 20);
+        start = Clock::now();
+        volume.ExtractTriangleMesh(config().fill_holes, config().min_weight);
+        report_.mesh_seconds = SecondsSince(start);
+        if (!keep_output) {
+            std::filesystem::remove(prefix + "_grid.vdb");
+            std::filesystem::remove(prefix + "_mesh.ply");
+        }
+        return volume;
+    }
+
+private:
+    vdbfusion::Mapper mapper_;
+    ReplayReport& report_;
+    double last_eviction_ = 0.0;
+};
+
+// Corridor drive seen by the sensor the config is tuned for: configs with LiDAR intrinsics get
+// 10 Hz sweeps at driving speed, the others 30 Hz VGA depth images from a hand-held camera. Poses
+// come at 100 Hz through the pose buffer, like the transform topic of the node.
+void ReplaySynthetic(const YamlParams& params,
+                     int n_scans,
+                     const geometry_msgs::Transform& static_tf,
+                     const ros::Duration& tolerance,
+                     Replayer& replayer) {
+    vdbfusion::SyntheticScene scene;
+    vdbfusion::SyntheticSensor sensor;
+    double rate = 10.0;
+    double speed = 10.0;
+    int rings = 0;
+    if (params.Get("lidar_rings", rings)) {
+        float fov_up = 2.0f;
+        float fov_down = -24.8f;
+        sensor.rows = rings;
+        params.Get("lidar_azimuth_bins", sensor.columns);
+        params.Get("lidar_fov_up", fov_up);
+        params.Get("lidar_fov_down", fov_down);
+        sensor.fov_up = fov_up * static_cast<float>(M_PI) / 180.0f;
+        sensor.fov_down = fov_down * static_cast<float>(M_PI) / 180.0f;
+        sensor.max_range = 120.0;
+    } else {
+        scene.half_width = 2.0;
+        scene.height = 2.5;
+        scene.pillar_spacing = 3.0;
+        scene.pillar_half_size = 0.2;
+        sensor.model = vdbfusion::SyntheticSensor::Model::kDepthCamera;
+        sensor.rows = 480;
+        sensor.columns = 640;
+        sensor.max_range = 10.0;
+        sensor.range_noise = 0.005;
+        rate = 30.0;
+        speed = 0.5;
+    }
+
+    const Sophus::SE3d T_static = TransformToSE3(static_tf);
+    vdbfusion::PoseBuffer poses;
+    poses.SetStaticTransform(static_tf);
+    const PoseLookup lookup = [&](const ros::Time& stamp,
+                                  geometry_msgs::TransformStamped& transform) {
+        return poses.Lookup(stamp, tolerance, transform);
+    };
+
+    constexpr double kPoseRate = 100.0;
+    int n_poses = 0;
+    sensor_msgs::PointCloud2 pcd;
+    for (int i = 0; i < n_scans; ++i) {
+        const double t = i / rate;
+        // Every pose up to the next one after the scan has arrived by the time it is looked up
+        for (; n_poses / kPoseRate <= t + 1.0 / kPoseRate; ++n_poses) {
+            const double pose_t = n_poses / kPoseRate;
+            geometry_msgs::TransformStamped pose;
+            pose.header.stamp = ros::Time(1.0 + pose_t);
+            pose.transform =
+                SE3ToTransform(vdbfusion::CorridorPose(scene, pose_t, speed) * T_static);
+            poses.Add(pose);
+        }
+        vdbfusion::RenderScan(scene, sensor, vdbfusion::CorridorPose(scene, t, speed),
+                              ros::Time(1.0 + t), i, pcd);
+        replayer.Integrate(pcd, lookup);
+    }
+}
+
+// Poses are loaded before the scans are replayed, the node would have them by the time it looks
+// them up
+void ReplayBag(const std::string& filename,
+               const YamlParams& params,
+               int max_scans,
+               const geometry_msgs::Transform& static_tf,
+               const ros::Duration& tolerance,
+               Replayer& replayer) {
+    bool use_tf2 = false;
+    std::string pcl_topic;
+    std::string tf_topic;
+    std::string parent_frame;
+    std::string child_frame;
+    params.Get("use_tf_transforms", use_tf2);
+    params.Get("pcl_topic", pcl_topic);
+    params.Get("tf_topic", tf_topic);
+    params.Get("parent_frame", parent_frame);
+    params.Get("child_frame", child_frame);
+
+    rosbag::Bag bag(filename, rosbag::bagmode::Read);
+    std::vector<std::string> pose_topics = {tf_topic};
+    if (use_tf2) {
+        pose_topics = {"/tf", "/tf_static"};
+    }
+    rosbag::View pose_view(bag, rosbag::TopicQuery(pose_topics));
+    tf2::BufferCore tf_buffer(pose_view.getEndTime() - pose_view.getBeginTime() +
+                              ros::Duration(1.0));
+    vdbfusion::PoseBuffer poses;
+    poses.SetStaticTransform(static_tf);
+    for (const rosbag::MessageInstance& message : pose_view) {
+        if (const auto tf_message = message.instantiate<tf2_msgs::TFMessage>()) {
+            const bool is_static = message.getTopic() == "/tf_static";
+            for (const auto& transform : tf_message->transforms) {
+                tf_buffer.setTransform(transform, "bag", is_static);
+            }
+        } else if (const auto transform = message.instantiate<geometry_msgs::TransformStamped>()) {
+            poses.Add(*transform);
+        }
+    }
+
+    const PoseLookup lookup = [&](const ros::Time& stamp,
+                                  geometry_msgs::TransformStamped& transform) {
+        if (!use_tf2) {
+            return poses.Lookup(stamp, tolerance, transform);
+        }
+        try {
+            transform = tf_buffer.lookupTransform(parent_frame, child_frame, stamp);
+        } catch (const tf2::TransformException&) {
+            return false;
+        }
+        return true;
+    };
+
+    int n_scans = 0;
+    rosbag::View scan_view(bag, rosbag::TopicQuery(pcl_topic));
+    for (const rosbag::MessageInstance& message : scan_view) {
+        if (max_scans > 0 && n_scans >= max_scans) {
+            break;
+        }
+        if (const auto pcd = message.instantiate<sensor_msgs::PointCloud2>()) {
+            replayer.Integrate(*pcd, lookup);
+            ++n_scans;
+        }
+    }
+}
+
+std::string CpuModel() {
+    std::ifstream cpuinfo("/proc/cpuinfo");
+    std::string line;
+    while (std::getline(cpuinfo, line)) {
+        if (line.rfind("model name", 0) == 0) {
+            const size_t colon = line.find(':');
+            return colon == std::string::npos ? std::string() : line.substr(colon + 2);
+        }
+    }
+    return std::string();
+}
+
+std::string Quoted(const std::string& text) {
+    std::string quoted = "\"";
+    for (const char c : text) {
+        if (c == '"' || c == '\\') {
+            quoted += '\\';
+        }
+        quoted += c;
+    }
+    return quoted + "\"";
+}
+
+// Nearest rank percentile
+double Percentile(std::vector<double> values, double p) {
+    if (values.empty()) {
+        return 0.0;
+    }
+    std::sort(values.begin(), values.end());
+    const auto rank = static_cast<size_t>(std::ceil(p * values.size()));
+    return values[std::clamp<size_t>(rank, 1, values.size()) - 1];
+}
+
+void WriteReport(const std::string& filename, const ReplayReport& report) {
+    const double seconds = report.replay_seconds;
+    std::ofstream out(filename);
+    out << "{\n"
+        << "  \"dataset\": " << Quoted(report.dataset) << ",\n"
+        << "  \"config\": " << Quoted(report.config) << ",\n"
+        << "  \"source\": " << Quoted(report.source) << ",\n"
+        << "  \"host\": {\"cpu\": " << Quoted(CpuModel())
+        << ", \"threads\": " << std::thread::hardware_concurrency() << "},\n"
+        << "  \"scans\": " << report.scans << ",\n"
+        << "  \"skipped_scans\": " << report.skipped_scans << ",\n"
+        << "  \"points\": " << report.points << ",\n"
+        << "  \"scans_per_second\": " << (seconds > 0.0 ? report.scans / seconds : 0.0) << ",\n"
+        << "  \"points_per_second\": " << (seconds > 0.0 ? report.points / seconds : 0.0) << ",\n"
+        << "  \"latency_ms\": {\"p50\": " << 1e3 * Percentile(report.latencies, 0.50)
+        << ", \"p99\": " << 1e3 * Percentile(report.latencies, 0.99)
+        << ", \"max\": " << 1e3 * Percentile(report.latencies, 1.0) << "},\n"
+        << "  \"stage_seconds\": {\"pose_lookup\": " << report.pose_lookup_seconds;
+    for (size_t i = 0; i < vdbfusion::kStageCount; ++i) {
+        const auto stage = static_cast<vdbfusion::Stage>(i);
+        out << ", " << Quoted(vdbfusion::StageName(stage)) << ": " << report.stages[stage].seconds;
+    }
+    out << "},\n";
+    if (report.hardware_counters) {
+        out << "  \"stage_counters\": {";
+        for (size_t i = 0; i < vdbfusion::kStageCount; ++i) {
+            const auto stage = static_cast<vdbfusion::Stage>(i);
+            out << (i ? ", " : "") << Quoted(vdbfusion::StageName(stage)) << ": {";
+            for (size_t j = 0; j < vdbfusion::kCounterCount; ++j) {
+                out << (j ? ", " : "")
+                    << Quoted(vdbfusion::CounterName(static_cast<vdbfusion::Counter>(j))) << ": "
+                    << report.stages[stage].counters[j];
+            }
+            out << "}";
+        }
+        out << "},\n";
+    }
+    out << "  \"save_seconds\": " << report.save_seconds << ",\n"
+        << "  \"mesh_seconds\": " << report.mesh_seconds << ",\n"
+        << "  \"active_voxels\": " << report.active_voxels << ",\n"
+        << "  \"leaves\": " << report.leaves << ",\n"
+        << "  \"grid_mb\": " << report.grid_mb << ",\n";
+    if (report.eviction) {
+        out << "  \"eviction\": {\"evicted_leaves\": " << report.evicted_leaves
+            << ", \"seconds\": " << report.eviction_seconds << "},\n";
+    }
+    if (report.raycast) {
+        const auto& raycast = *report.raycast;
+        const double points_per_second = seconds > 0.0 ? report.points / seconds : 0.0;
+        out << "  \"raycast_comparison\": {\"points_per_second\": "
+            << report.raycast_points_per_second << ", \"speedup\": "
+            << (report.raycast_points_per_second > 0.0
+                    ? points_per_second / report.raycast_points_per_second
+                    : 0.0)
+            << ", \"common_voxels\": " << raycast.common_voxels
+            << ", \"only_in_result\": " << raycast.only_in_result
+            << ", \"only_in_raycast\": " << raycast.only_in_reference
+            << ", \"jaccard\": " << raycast.jaccard << ", \"tsdf_rms\": " << raycast.tsdf_rms
+            << ", \"chamfer_mean\": " << raycast.chamfer_mean
+            << ", \"chamfer_p95\": " << raycast.chamfer_p95
+            << ", \"vertices\": " << raycast.vertices
+            << ", \"unmatched_vertices\": " << raycast.unmatched_vertices << "},\n";
+    }
+    out << "  \"peak_rss_mb\": " << report.peak_rss_mb << "\n"
+        << "}\n";
+}
+
+struct Dataset {
+    std::string config;
+    std::string bag;
+};
+
+// Replays the dataset with config into report and returns the final map
+vdbfusion::VDBVolume ReplayDataset(const Dataset& dataset,
+                                   const YamlParams& params,
+                                   const vdbfusion::MapperConfig& config,
+                                   int max_scans,
+                                   const std::string& prefix,
+                                   bool keep_output,
+                                   ReplayReport& report) {
+    int tolerance_ns = 0;
+    params.Get("timestamp_tolerance_ns", tolerance_ns);
+    const ros::Duration tolerance(0, tolerance_ns);
+    const geometry_msgs::Transform static_tf = vdbfusion::ReadStaticTransform(params);
+
+    vdbfusion::ResetPeakResidentSetSize();
+    Replayer replayer(config, report);
+    report.hardware_counters = replayer.config().hardware_counters;
+    report.eviction = replayer.config().eviction;
+    if (dataset.bag.empty()) {
+        ReplaySynthetic(params, max_scans > 0 ? max_scans : 100, static_tf, tolerance, replayer);
+    } else {
+        ReplayBag(dataset.bag, params, max_scans, static_tf, tolerance, replayer);
+    }
+    auto volume = replayer.Finish(prefix, keep_output);
+    report.peak_rss_mb = static_cast<double>(vdbfusion::PeakResidentSetSize()) / (1 << 20);
+    return volume;
+}
+
+void PrintSummary(const ReplayReport& report) {
+    std::printf("%-12s %6zu scans %8.1f scans/s  p50 %7.2f ms  p99 %7.2f ms  save %6.2f s  "
+                "%10zu voxels  %8.1f MB\n",
+                report.dataset.c_str(), report.scans,
+                report.replay_seconds > 0.0 ? report.scans / report.replay_seconds : 0.0,
+                1e3 * Percentile(report.latencies, 0.50), 1e3 * Percentile(report.latencies, 0.99),
+                report.save_seconds, report.active_voxels, report.peak_rss_mb);
+    if (report.hardware_counters) {
+        std::printf("%s\n", vdbfusion::FormatSummary(report.stages).c_str());
+    }
+}
+}  // namespace
+
+int main(int argc, char** argv) {
+    int max_scans = -1;
+    bool keep_output = false;
+    bool hardware_counters = false;
+    bool compare_raycast = false;
+    std::string integration_mode;
+    std::string output_dir = ".";
+    std::string bag;
+    std::vector<Dataset> datasets;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--scans" && i + 1 < argc) {
+            max_scans = std::atoi(argv[++i]);
+        } else if (arg == "--output_dir" && i + 1 < argc) {
+            output_dir = argv[++i];
+        } else if (arg == "--keep_output") {
+            keep_output = true;
+        } else if (arg == "--hardware_counters") {
+            hardware_counters = true;
+        } else if (arg == "--compare_raycast") {
+            compare_raycast = true;
+        } else if (arg == "--integration_mode" && i + 1 < argc) {
+            integration_mode = argv[++i];
+        } else if (arg == "--bag" && i + 1 < argc) {
+            bag = argv[++i];
+        } else if (arg.rfind("--", 0) == 0) {
+            PrintUsage(argv[0]);
+            return 2;
+        } else {
+            datasets.push_back({arg, bag});
+            bag.clear();
+        }
+    }
+    if (datasets.empty()) {
+        PrintUsage(argv[0]);
+        return 2;
+    }
+    // The per-scan messages of the mapper would dominate the output
+    if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn)) {
+        ros::console::notifyLoggerLevelsChanged();
+    }
+    std::filesystem::create_directories(output_dir);
+
+    for (const auto& dataset : datasets) {
+        ReplayReport report;
+        report.dataset = std::filesystem::path(dataset.config).stem().string();
+        report.config = dataset.config;
+        report.source = dataset.bag.empty() ? "synthetic" : dataset.bag;
+
+        YamlParams params(dataset.config);
+        if (!integration_mode.empty()) {
+            params.Override("integration_mode", integration_mode);
+        }
+        auto config = vdbfusion::ReadMapperConfig(params);
+        config.hardware_counters |= hardware_counters;
+        const auto prefix = std::filesystem::path(output_dir) / report.dataset;
+        std::optional<vdbfusion::VDBVolume> volume = ReplayDataset(
+            dataset, params, config, max_scans, prefix.string(), keep_output, report);
+
+        // The same scans through the raycast path, only the result map is kept in the meantime
+        if (compare_raycast && (config.projective || config.beam_model)) {
+            ReplayReport raycast_report;
+            raycast_report.dataset = report.dataset + "_raycast";
+            raycast_report.config = report.config;
+            raycast_report.source = report.source;
+            auto raycast_config = config;
+            raycast_config.projective = false;
+            raycast_config.beam_model = false;
+            const auto raycast_prefix = std::filesystem::path(output_dir) / raycast_report.dataset;
+            const auto raycast_volume =
+                ReplayDataset(dataset, params, raycast_config, max_scans, raycast_prefix.string(),
+                              keep_output, raycast_report);
+            report.raycast = vdbfusion::CompareVolumes(*volume, raycast_volume, config.fill_holes,
+                                                       config.min_weight);
+            report.raycast_points_per_second =
+                raycast_report.replay_seconds > 0.0
+                    ? raycast_report.points / raycast_report.replay_seconds
+                    : 0.0;
+            const auto raycast_filename =
+                std::filesystem::path(output_dir) / (raycast_report.dataset + ".json");
+            WriteReport(raycast_filename.string(), raycast_report);
+            PrintSummary(raycast_report);
+        }
+        volume.reset();
+
+        const auto filename = std::filesystem::path(output_dir) / (report.dataset + ".json");
+        WriteReport(filename.string(), report);
+        PrintSummary(report);
+        if (report.raycast) {
+            std::printf("%-12s vs raycast: jaccard %.4f  tsdf rms %.4f m  chamfer mean %.4f m  "
+                        "p95 %.4f m  unmatched %zu of %zu vertices\n",
+                        report.dataset.c_str(), report.raycast->jaccard, report.raycast->tsdf_rms,
+                        report.raycast->chamfer_mean, report.raycast->chamfer_p95,
+                        report.raycast->unmatched_vertices, report.raycast->vertices);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,95 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RosParams.hpp"
+
+#include <ros/ros.h>
+
+#include <string>
+#include <utility>
+#include <vector>
+
+bool vdbfusion::RosParams::Get(const std::string& name, bool& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name, int& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name, float& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name, double& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name, std::string& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name, std::vector<float>& value) const {
+    return nh_.getParam("/" + name, value);
+}
+
+bool vdbfusion::RosParams::Get(const std::string& name,
+                               std::vector<std::vector<float>>& value) const {
+    XmlRpc::XmlRpcValue list;
+    if (!nh_.getParam("/" + name, list)) {
+        return false;
+    }
+    if (list.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+        ROS_WARN_STREAM(name << " must be a list of lists, ignoring it");
+        return false;
+    }
+    const auto is_number = [](XmlRpc::XmlRpcValue& entry) {
+        return entry.getType() == XmlRpc::XmlRpcValue::TypeDouble ||
+               entry.getType() == XmlRpc::XmlRpcValue::TypeInt;
+    };
+    const auto to_float = [](XmlRpc::XmlRpcValue& entry) {
+        return entry.getType() == XmlRpc::XmlRpcValue::TypeInt
+                   ? static_cast<float>(static_cast<int>(entry))
+                   : static_cast<float>(static_cast<double>(entry));
+    };
+    value.clear();
+    for (int i = 0; i < list.size(); ++i) {
+        auto& inner = list[i];
+        if (inner.getType() != XmlRpc::XmlRpcValue::TypeArray) {
+            ROS_WARN_STREAM("Ignoring " << name << "[" << i << "], expected a list");
+            continue;
+        }
+        std::vector<float> numbers;
+        for (int j = 0; j < inner.size(); ++j) {
+            if (!is_number(inner[j])) {
+                break;
+            }
+            numbers.push_back(to_float(inner[j]));
+        }
+        if (static_cast<int>(numbers.size()) != inner.size()) {
+            ROS_WARN_STREAM("Ignoring " << name << "[" << i << "], expected numbers");
+            continue;
+        }
+        value.push_back(std::move(numbers));
+    }
+    return true;
+}
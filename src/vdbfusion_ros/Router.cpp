@@ -0,0 +1,111 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Router.hpp"
+
+#include <geometry_msgs/TransformStamped.h>
+#include <ros/ros.h>
+
+#include <cstring>
+#include <string>
+
+#include "Decode.hpp"
+
+vdbfusion::ScanRouter::ScanRouter() : tf_(nh_) {
+    std::string pcl_topic;
+    nh_.getParam("/pcl_topic", pcl_topic);
+    nh_.getParam("/apply_pose", apply_pose_);
+    nh_.param("/shard_count", layout_.shards, 2);
+    nh_.param("/shard_tile_size", layout_.tile_size, 50.0);
+
+    int32_t tol;
+    nh_.getParam("/timestamp_tolerance_ns", tol);
+    timestamp_tolerance_ = ros::Duration(0, tol);
+
+    const int queue_size = 500;
+
+    shard_scans_.resize(layout_.shards);
+    for (int shard = 0; shard < layout_.shards; ++shard) {
+        shard_pubs_.push_back(nh_.advertise<sensor_msgs::PointCloud2>(
+            ShardNamespace(shard) + "/points", queue_size));
+    }
+    sub_ = nh_.subscribe(pcl_topic, queue_size, &vdbfusion::ScanRouter::Route, this);
+
+    ROS_INFO("Routing '%s' to %d shards of %.1f m tiles", pcl_topic.c_str(), layout_.shards,
+             layout_.tile_size);
+}
+
+void vdbfusion::ScanRouter::Route(const sensor_msgs::PointCloud2& pcd) {
+    geometry_msgs::TransformStamped transform;
+    if (!tf_.lookUpTransform(pcd.header.stamp, timestamp_tolerance_, transform)) {
+        return;
+    }
+    // The shards integrate whole rays, so a point goes to the shard owning its endpoint even if
+    // the ray crosses other tiles. The layout is kept to map every decoded point to its bytes.
+    const Sophus::SE3d pose = TransformToSE3(transform.transform);
+    pcl2SensorMsgToScanBuffer(pcd, scan_, true);
+    ToWorld(scan_, apply_pose_ ? pose : Sophus::SE3d(), world_points_);
+
+    for (auto& shard_scan : shard_scans_) {
+        shard_scan.header = pcd.header;
+        shard_scan.fields = pcd.fields;
+        shard_scan.is_bigendian = pcd.is_bigendian;
+        shard_scan.point_step = pcd.point_step;
+        shard_scan.height = 1;
+        shard_scan.width = 0;
+        shard_scan.is_dense = true;
+        shard_scan.data.clear();
+    }
+    for (size_t i = 0; i < scan_.size(); ++i) {
+        const float x = scan_.x[i];
+        const float y = scan_.y[i];
+        const float z = scan_.z[i];
+        const bool valid = ((x - x) == 0.0f) & ((y - y) == 0.0f) & ((z - z) == 0.0f) &
+                           ((x != 0.0f) | (y != 0.0f) | (z != 0.0f));
+        if (!valid) {
+            continue;
+        }
+        auto& shard_scan = shard_scans_[layout_.ShardOf(world_points_[i])];
+        const size_t row = i / pcd.width;
+        const size_t col = i % pcd.width;
+        const uint8_t* point = pcd.data.data() + row * pcd.row_step + col * pcd.point_step;
+        const size_t offset = shard_scan.data.size();
+        shard_scan.data.resize(offset + pcd.point_step);
+        std::memcpy(shard_scan.data.data() + offset, point, pcd.point_step);
+        ++shard_scan.width;
+    }
+
+    for (int shard = 0; shard < layout_.shards; ++shard) {
+        auto& shard_scan = shard_scans_[shard];
+        if (shard_scan.width == 0) {
+            continue;
+        }
+        shard_scan.row_step = shard_scan.width * shard_scan.point_step;
+        shard_pubs_[shard].publish(shard_scan);
+    }
+}
+
+int main(int argc, char** argv) {
+    ros::init(argc, argv, "vdbfusion_router");
+    vdbfusion::ScanRouter router;
+    ros::spin();
+}
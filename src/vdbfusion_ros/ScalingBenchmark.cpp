@@ -0,0 +1,234 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <openvdb/math/DDA.h>
+#include <openvdb/math/Ray.h>
+#include <openvdb/openvdb.h>
+#include <ros/console.h>
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <Eigen/Core>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "Decode.hpp"
+#include "LeafPool.hpp"
+#include "ScanBuffer.hpp"
+#include "SyntheticScans.hpp"
+#include "sophus/se3.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace {
+using Clock = std::chrono::steady_clock;
+
+void PrintUsage(const char* program) {
+    std::cerr << "Usage: " << program
+              << " [--voxel_size <float>] [--sdf_trunc <float>] [--max_voxels <float>]"
+                 " [--max_scans <int>] [--speed <m/s>] [--output <scaling.csv>]\n"
+              << "Drives down a synthetic corridor and integrates 10 Hz LiDAR sweeps until the map "
+                 "holds max_voxels active voxels (1e8), one CSV row per scan.\n";
+}
+
+struct Options {
+    float voxel_size = 0.1f;
+    float sdf_trunc = 0.3f;
+    double max_voxels = 1e8;
+    int max_scans = 0;
+    double speed = 5.0;
+    std::string output = "scaling.csv";
+};
+
+struct AccessStats {
+    size_t accesses = 0;
+    // Not in the cached leaf
+    size_t leaf_misses = 0;
+    // Not under any cached node, the access starts over at the root
+    size_t root_misses = 0;
+};
+
+// Replays the voxel accesses of VDBVolume::Integrate on the tsdf grid: the same rays, traversed
+// by the same DDA in the same order. A ValueAccessor caches the leaf, lower and upper internal
+// node of its last access and serves an access from the deepest cached node holding the voxel,
+// which only depends on the coordinates once the nodes exist.
+AccessStats AccessPattern(const vdbfusion::VDBVolume& volume,
+                          const std::vector<Eigen::Vector3d>& points,
+                          const Eigen::Vector3d& origin) {
+    using TreeT = openvdb::FloatTree;
+    using LeafT = TreeT::LeafNodeType;
+    using LowerT = TreeT::RootNodeType::ChildNodeType::ChildNodeType;
+    using UpperT = TreeT::RootNodeType::ChildNodeType;
+    constexpr int kLeafShift = LeafT::TOTAL;
+    constexpr int kLowerShift = LowerT::TOTAL;
+    constexpr int kUpperShift = UpperT::TOTAL;
+    const openvdb::Coord none(std::numeric_limits<openvdb::Int32>::max());
+
+    AccessStats stats;
+    openvdb::Coord leaf = none;
+    openvdb::Coord lower = none;
+    openvdb::Coord upper = none;
+    const openvdb::Vec3R eye(origin.x(), origin.y(), origin.z());
+    for (const auto& point : points) {
+        const Eigen::Vector3d direction = point - origin;
+        openvdb::Vec3R dir(direction.x(), direction.y(), direction.z());
+        dir.normalize();
+        const auto depth = static_cast<float>(direction.norm());
+        const float t0 = volume.space_carving_ ? 0.0f : depth - volume.sdf_trunc_;
+        const float t1 = depth + volume.sdf_trunc_;
+        const auto ray = openvdb::math::Ray<float>(eye, dir, t0, t1).worldToIndex(*volume.tsdf_);
+        openvdb::math::DDA<decltype(ray)> dda(ray);
+        do {
+            const openvdb::Coord voxel = dda.voxel();
+            ++stats.accesses;
+            if ((voxel >> kLeafShift) == leaf) {
+                continue;
+            }
+            ++stats.leaf_misses;
+            leaf = voxel >> kLeafShift;
+            if ((voxel >> kLowerShift) == lower) {
+                continue;
+            }
+            lower = voxel >> kLowerShift;
+            if ((voxel >> kUpperShift) == upper) {
+                continue;
+            }
+            upper = voxel >> kUpperShift;
+            ++stats.root_misses;
+        } while (dda.step());
+    }
+    return stats;
+}
+
+// Totals of the scans integrated while the map was within one decade of active voxels
+struct Decade {
+    size_t scans = 0;
+    double points = 0.0;
+    double seconds = 0.0;
+    AccessStats access;
+    double rss_mb = 0.0;
+};
+}  // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string arg = argv[i];
+        if (arg == "--voxel_size" && i + 1 < argc) {
+            options.voxel_size = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--sdf_trunc" && i + 1 < argc) {
+            options.sdf_trunc = std::strtof(argv[++i], nullptr);
+        } else if (arg == "--max_voxels" && i + 1 < argc) {
+            options.max_voxels = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--max_scans" && i + 1 < argc) {
+            options.max_scans = std::atoi(argv[++i]);
+        } else if (arg == "--speed" && i + 1 < argc) {
+            options.speed = std::strtod(argv[++i], nullptr);
+        } else if (arg == "--output" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else {
+            PrintUsage(argv[0]);
+            return 2;
+        }
+    }
+    if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn)) {
+        ros::console::notifyLoggerLevelsChanged();
+    }
+
+    openvdb::initialize();
+    vdbfusion::VDBVolume volume(options.voxel_size, options.sdf_trunc, false);
+    const auto weighting_function = [](float /*unused*/) { return 1.0f; };
+
+    const vdbfusion::SyntheticScene scene;
+    const vdbfusion::SyntheticSensor sensor;
+    vdbfusion::PointFilter filter;
+    filter.min_range = 0.5f;
+    sensor_msgs::PointCloud2 pcd;
+    vdbfusion::ScanBuffer scan;
+    std::vector<Eigen::Vector3d> points;
+
+    std::ofstream csv(options.output);
+    csv << "scan,active_voxels,leaves,points,integrate_ms,ns_per_point,leaf_miss_rate,"
+           "root_miss_rate,grid_mb,rss_mb\n";
+    std::map<int, Decade> decades;
+    for (int i = 0; options.max_scans <= 0 || i < options.max_scans; ++i) {
+        const double t = 0.1 * i;
+        const Sophus::SE3d pose = vdbfusion::CorridorPose(scene, t, options.speed);
+        vdbfusion::RenderScan(scene, sensor, pose, ros::Time(1.0 + t), i, pcd);
+        vdbfusion::pcl2SensorMsgToScanBuffer(pcd, scan, false);
+        vdbfusion::ApplyFilter(scan, filter);
+        vdbfusion::ToWorld(scan, pose, points);
+
+        const auto start = Clock::now();
+        volume.Integrate(points, pose.translation(), weighting_function);
+        const double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+        const AccessStats access = AccessPattern(volume, points, pose.translation());
+        const auto active_voxels = volume.tsdf_->activeVoxelCount();
+        const double grid_mb =
+            static_cast<double>(volume.tsdf_->memUsage() + volume.weights_->memUsage()) /
+            (1 << 20);
+        const double rss_mb = static_cast<double>(vdbfusion::ResidentSetSize()) / (1 << 20);
+        const double n_points = static_cast<double>(points.size());
+        const double accesses = static_cast<double>(std::max<size_t>(access.accesses, 1));
+        csv << i << ',' << active_voxels << ',' << volume.tsdf_->tree().leafCount() << ','
+            << points.size() << ',' << 1e3 * seconds << ','
+            << (n_points > 0.0 ? 1e9 * seconds / n_points : 0.0) << ','
+            << access.leaf_misses / accesses << ',' << access.root_misses / accesses << ','
+            << grid_mb << ',' << rss_mb << '\n';
+
+        auto& decade = decades[static_cast<int>(std::floor(std::log10(std::max<double>(
+            static_cast<double>(active_voxels), 1.0))))];
+        ++decade.scans;
+        decade.points += n_points;
+        decade.seconds += seconds;
+        decade.access.accesses += access.accesses;
+        decade.access.leaf_misses += access.leaf_misses;
+        decade.access.root_misses += access.root_misses;
+        decade.rss_mb = rss_mb;
+        if (i % 100 == 0) {
+            std::cerr << "scan " << i << ": " << active_voxels << " active voxels, "
+                      << rss_mb << " MB\n";
+        }
+        if (static_cast<double>(active_voxels) >= options.max_voxels) {
+            break;
+        }
+    }
+
+    std::printf("%-14s %8s %12s %14s %14s %10s\n", "active voxels", "scans", "ns/point",
+                "leaf misses", "root misses", "RSS MB");
+    for (const auto& [exponent, decade] : decades) {
+        const double accesses = static_cast<double>(std::max<size_t>(decade.access.accesses, 1));
+        std::printf("1e%-12d %8zu %12.1f %13.3f%% %13.4f%% %10.1f\n", exponent, decade.scans,
+                    decade.points > 0.0 ? 1e9 * decade.seconds / decade.points : 0.0,
+                    100.0 * decade.access.leaf_misses / accesses,
+                    100.0 * decade.access.root_misses / accesses, decade.rss_mb);
+    }
+    return 0;
+}
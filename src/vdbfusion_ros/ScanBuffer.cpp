@@ -0,0 +1,178 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ScanBuffer.hpp"
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include "sophus/se3.hpp"
+
+namespace {
+// Stream compaction of a single channel, the write index advances without branching
+template <typename T>
+void CompactChannel(vdbfusion::AlignedVector<T>& values,
+                    const vdbfusion::AlignedVector<uint8_t>& keep) {
+    if (values.empty()) {
+        return;
+    }
+    T* __restrict data = values.data();
+    const uint8_t* __restrict mask = keep.data();
+    size_t j = 0;
+    for (size_t i = 0; i < values.size(); ++i) {
+        data[j] = data[i];
+        j += mask[i];
+    }
+    values.resize(j);
+}
+
+uint64_t VoxelKey(int32_t i, int32_t j, int32_t k) {
+    constexpr int32_t kOffset = 1 << 20;
+    constexpr uint64_t kMask = (uint64_t(1) << 21) - 1;
+    return ((uint64_t(i + kOffset) & kMask) << 42) | ((uint64_t(j + kOffset) & kMask) << 21) |
+           (uint64_t(k + kOffset) & kMask);
+}
+
+uint64_t Hash(uint64_t key) {
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return key;
+}
+}  // namespace
+
+void vdbfusion::ScanBuffer::clear() { resize(0, false, false, false); }
+
+void vdbfusion::ScanBuffer::resize(size_t n, bool with_intensity, bool with_time, bool with_ring) {
+    x.resize(n);
+    y.resize(n);
+    z.resize(n);
+    intensity.resize(with_intensity ? n : 0);
+    time.resize(with_time ? n : 0);
+    ring.resize(with_ring ? n : 0);
+}
+
+void vdbfusion::ScanBuffer::Compact() {
+    CompactChannel(x, keep);
+    CompactChannel(y, keep);
+    CompactChannel(z, keep);
+    CompactChannel(intensity, keep);
+    CompactChannel(time, keep);
+    CompactChannel(ring, keep);
+}
+
+void vdbfusion::ComputeKeepMask(ScanBuffer& scan, const PointFilter& filter) {
+    constexpr size_t kBlock = 1024;
+    const size_t n = scan.size();
+    scan.keep.resize(n);
+    const float* __restrict x = scan.x.data();
+    const float* __restrict y = scan.y.data();
+    const float* __restrict z = scan.z.data();
+    uint8_t* __restrict keep = scan.keep.data();
+    const float min_range2 = filter.min_range * filter.min_range;
+    const float max_range2 = filter.max_range >= std::sqrt(std::numeric_limits<float>::max())
+                                 ? std::numeric_limits<float>::max()
+                                 : filter.max_range * filter.max_range;
+    const auto inside = [&](const CropBox& box, size_t i) {
+        return (x[i] >= box.min.x()) & (x[i] <= box.max.x()) & (y[i] >= box.min.y()) &
+               (y[i] <= box.max.y()) & (z[i] >= box.min.z()) & (z[i] <= box.max.z());
+    };
+
+    uint8_t included[kBlock];
+    for (size_t begin = 0; begin < n; begin += kBlock) {
+        const size_t end = std::min(n, begin + kBlock);
+        // NaN fails every comparison and inf - inf is NaN, so non-finite points are rejected too.
+        // Zero range points are "no return" markers of organized clouds.
+        for (size_t i = begin; i < end; ++i) {
+            const float range2 = x[i] * x[i] + y[i] * y[i] + z[i] * z[i];
+            keep[i] = (range2 > 0.0f) & (range2 >= min_range2) & (range2 <= max_range2) &
+                      ((x[i] - x[i]) == 0.0f) & ((y[i] - y[i]) == 0.0f) & ((z[i] - z[i]) == 0.0f);
+        }
+        for (const auto& box : filter.exclusion_boxes) {
+            for (size_t i = begin; i < end; ++i) {
+                keep[i] &= !inside(box, i);
+            }
+        }
+        if (filter.inclusion_boxes.empty()) {
+            continue;
+        }
+        std::fill(included, included + (end - begin), 0);
+        for (const auto& box : filter.inclusion_boxes) {
+            for (size_t i = begin; i < end; ++i) {
+                included[i - begin] |= inside(box, i);
+            }
+        }
+        for (size_t i = begin; i < end; ++i) {
+            keep[i] &= included[i - begin];
+        }
+    }
+}
+
+void vdbfusion::ApplyFilter(ScanBuffer& scan, const PointFilter& filter) {
+    ComputeKeepMask(scan, filter);
+    scan.Compact();
+}
+
+void vdbfusion::VoxelFilter(ScanBuffer& scan, float voxel_size) {
+    const size_t n = scan.size();
+    scan.keep.resize(n);
+    if (n == 0) {
+        return;
+    }
+    // Open addressing table of occupied voxels, at most half full
+    size_t capacity = 1;
+    while (capacity < 2 * n) {
+        capacity <<= 1;
+    }
+    constexpr uint64_t kEmpty = ~uint64_t(0);
+    scan.voxel_table.assign(capacity, kEmpty);
+
+    const float inv_voxel_size = 1.0f / voxel_size;
+    uint64_t* table = scan.voxel_table.data();
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t key = VoxelKey(static_cast<int32_t>(std::floor(scan.x[i] * inv_voxel_size)),
+                                      static_cast<int32_t>(std::floor(scan.y[i] * inv_voxel_size)),
+                                      static_cast<int32_t>(std::floor(scan.z[i] * inv_voxel_size)));
+        size_t slot = Hash(key) & (capacity - 1);
+        while (table[slot] != kEmpty && table[slot] != key) {
+            slot = (slot + 1) & (capacity - 1);
+        }
+        scan.keep[i] = table[slot] == kEmpty;
+        table[slot] = key;
+    }
+    scan.Compact();
+}
+
+void vdbfusion::ToWorld(const ScanBuffer& scan,
+                        const Sophus::SE3d& T,
+                        std::vector<Eigen::Vector3d>& points) {
+    const Eigen::Matrix3f R = T.rotationMatrix().cast<float>();
+    const Eigen::Vector3d& t = T.translation();
+    points.resize(scan.size());
+    for (size_t i = 0; i < scan.size(); ++i) {
+        const Eigen::Vector3f p = R * Eigen::Vector3f(scan.x[i], scan.y[i], scan.z[i]);
+        points[i] = p.cast<double>() + t;
+    }
+}
@@ -0,0 +1,151 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ScanHistory.hpp"
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <utility>
+#include <vector>
+
+#include "sophus/se3.hpp"
+
+namespace {
+// Quantizes the points in place, they become exactly what Dequantize gives back
+void Quantize(vdbfusion::ScanRecord& record, std::vector<Eigen::Vector3d>& points) {
+    const Eigen::Vector3d& origin = record.pose.translation();
+    double max_offset = 0.0;
+    for (const auto& point : points) {
+        max_offset = std::max(max_offset, (point - origin).cwiseAbs().maxCoeff());
+    }
+    record.step = max_offset > 0.0 ? max_offset / std::numeric_limits<int16_t>::max() : 1.0;
+    record.offsets.resize(3 * points.size());
+    const double inv_step = 1.0 / record.step;
+    for (size_t i = 0; i < points.size(); ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            const double offset = points[i][axis] - origin[axis];
+            const auto q = static_cast<int16_t>(std::lround(offset * inv_step));
+            record.offsets[3 * i + axis] = q;
+            points[i][axis] = origin[axis] + q * record.step;
+        }
+    }
+}
+
+void Dequantize(const vdbfusion::ScanRecord& record, std::vector<Eigen::Vector3d>& points) {
+    const Eigen::Vector3d& origin = record.pose.translation();
+    points.resize(record.offsets.size() / 3);
+    for (size_t i = 0; i < points.size(); ++i) {
+        for (int axis = 0; axis < 3; ++axis) {
+            points[i][axis] = origin[axis] + record.offsets[3 * i + axis] * record.step;
+        }
+    }
+}
+}  // namespace
+
+void vdbfusion::ScanHistory::Add(double stamp,
+                                 const Sophus::SE3d& pose,
+                                 std::vector<Eigen::Vector3d>& points) {
+    ScanRecord record{stamp, pose, 0.0, {}};
+    Quantize(record, points);
+    bytes_ += record.offsets.size() * sizeof(int16_t);
+    records_.push_back(std::move(record));
+}
+
+bool vdbfusion::ScanHistory::Expire(ScanBatch& expired) {
+    expired.clear();
+    if (records_.empty() || duration_ <= 0.0) {
+        return false;
+    }
+    const double oldest_kept = records_.back().stamp - duration_;
+    while (!records_.empty() && records_.front().stamp < oldest_kept) {
+        const ScanRecord& record = records_.front();
+        Dequantize(record, expired.Add(record.pose.translation()));
+        bytes_ -= record.offsets.size() * sizeof(int16_t);
+        records_.pop_front();
+    }
+    return !expired.empty();
+}
+
+size_t vdbfusion::ScanHistory::Correct(const std::vector<PoseCorrection>& corrections,
+                                       double tolerance,
+                                       double max_translation,
+                                       double max_rotation,
+                                       ScanBatch& removed,
+                                       ScanBatch& added) {
+    removed.clear();
+    added.clear();
+    const auto by_stamp = [](const ScanRecord& record, double stamp) {
+        return record.stamp < stamp;
+    };
+    // Record index and correction of every match
+    std::vector<std::pair<size_t, const PoseCorrection*>> matches;
+    for (const auto& correction : corrections) {
+        // Closest record within tolerance, the records are in stamp order
+        auto it = std::lower_bound(records_.begin(), records_.end(),
+                                   correction.stamp - tolerance, by_stamp);
+        if (it == records_.end() || it->stamp > correction.stamp + tolerance) {
+            continue;
+        }
+        auto next = std::next(it);
+        if (next != records_.end() && next->stamp <= correction.stamp + tolerance &&
+            std::abs(next->stamp - correction.stamp) < std::abs(it->stamp - correction.stamp)) {
+            it = next;
+        }
+        matches.emplace_back(it - records_.begin(), &correction);
+    }
+
+    // A record matched by several corrections takes the last of them, so that it is removed and
+    // added once
+    std::stable_sort(matches.begin(), matches.end(),
+                     [](const auto& a, const auto& b) { return a.first < b.first; });
+    for (size_t i = 0; i < matches.size(); ++i) {
+        if (i + 1 < matches.size() && matches[i + 1].first == matches[i].first) {
+            continue;
+        }
+        ScanRecord& record = records_[matches[i].first];
+        const PoseCorrection& correction = *matches[i].second;
+        const Sophus::SE3d delta = record.pose.inverse() * correction.pose;
+        if (delta.translation().norm() <= max_translation &&
+            delta.so3().log().norm() <= max_rotation) {
+            continue;
+        }
+
+        auto& old_points = removed.Add(record.pose.translation());
+        Dequantize(record, old_points);
+        // Points move with the scan: p' = T_new * T_old^-1 * p
+        const Sophus::SE3d T_new_old = correction.pose * record.pose.inverse();
+        auto& new_points = added.Add(correction.pose.translation());
+        new_points.resize(old_points.size());
+        for (size_t p = 0; p < old_points.size(); ++p) {
+            new_points[p] = T_new_old * old_points[p];
+        }
+        bytes_ -= record.offsets.size() * sizeof(int16_t);
+        record.pose = correction.pose;
+        Quantize(record, new_points);
+        bytes_ += record.offsets.size() * sizeof(int16_t);
+    }
+    return removed.size();
+}
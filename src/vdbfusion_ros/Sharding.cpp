@@ -0,0 +1,40 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Sharding.hpp"
+
+#include <Eigen/Core>
+#include <cmath>
+#include <cstdint>
+#include <string>
+
+int vdbfusion::ShardLayout::ShardOf(const Eigen::Vector3d& world_point) const {
+    const auto tile_x = static_cast<int64_t>(std::floor(world_point.x() / tile_size));
+    const auto tile_y = static_cast<int64_t>(std::floor(world_point.y() / tile_size));
+    uint64_t key = (static_cast<uint64_t>(tile_x) << 32) ^ static_cast<uint32_t>(tile_y);
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    return static_cast<int>(key % static_cast<uint64_t>(shards));
+}
+
+std::string vdbfusion::ShardNamespace(int shard) { return "/shard_" + std::to_string(shard); }
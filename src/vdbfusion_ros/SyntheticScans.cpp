@@ -0,0 +1,169 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "SyntheticScans.hpp"
+
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/PointField.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+#include "sophus/se3.hpp"
+
+namespace {
+// Uniform in [-1, 1], a hash of the seed and the ray index
+double Noise(uint32_t seed, uint32_t ray) {
+    uint64_t key = (uint64_t(seed) << 32) | ray;
+    key ^= key >> 33;
+    key *= 0xff51afd7ed558ccdULL;
+    key ^= key >> 33;
+    key *= 0xc4ceb9fe1a85ec53ULL;
+    key ^= key >> 33;
+    return static_cast<double>(key >> 11) * (2.0 / static_cast<double>(uint64_t(1) << 53)) - 1.0;
+}
+
+// Smallest positive distance to the plane coordinate = bound along one axis
+double ToPlane(double origin, double direction, double bound) {
+    if (direction == 0.0) {
+        return std::numeric_limits<double>::infinity();
+    }
+    const double t = (bound - origin) / direction;
+    return t > 0.0 ? t : std::numeric_limits<double>::infinity();
+}
+
+Eigen::Vector3d RayDirection(const vdbfusion::SyntheticSensor& sensor, int row, int column) {
+    if (sensor.model == vdbfusion::SyntheticSensor::Model::kLiDAR) {
+        const double elevation =
+            sensor.fov_up - (sensor.fov_up - sensor.fov_down) * row / std::max(1, sensor.rows - 1);
+        const double azimuth = M_PI - 2.0 * M_PI * (column + 0.5) / sensor.columns;
+        return {std::cos(elevation) * std::cos(azimuth), std::cos(elevation) * std::sin(azimuth),
+                std::sin(elevation)};
+    }
+    const double focal = 0.5 * sensor.columns / std::tan(0.5 * sensor.fov_horizontal);
+    const double u = column + 0.5 - 0.5 * sensor.columns;
+    const double v = row + 0.5 - 0.5 * sensor.rows;
+    return Eigen::Vector3d(focal, -u, -v).normalized();
+}
+}  // namespace
+
+double vdbfusion::SyntheticScene::Cast(const Eigen::Vector3d& origin,
+                                       const Eigen::Vector3d& direction,
+                                       double max_range) const {
+    double t = std::min({max_range, ToPlane(origin.y(), direction.y(), half_width),
+                         ToPlane(origin.y(), direction.y(), -half_width),
+                         ToPlane(origin.z(), direction.z(), 0.0),
+                         ToPlane(origin.z(), direction.z(), height)});
+
+    // Slab test against the pillars the ray can reach, they span the whole height
+    const double reach = std::abs(direction.x()) * t + pillar_half_size;
+    const auto first = static_cast<int64_t>(std::floor((origin.x() - reach) / pillar_spacing));
+    const auto last = static_cast<int64_t>(std::ceil((origin.x() + reach) / pillar_spacing));
+    for (int64_t k = first; k <= last; ++k) {
+        const double cx = static_cast<double>(k) * pillar_spacing;
+        const double cy = (k % 2 == 0 ? 0.5 : -0.5) * half_width;
+        double t_enter = 0.0;
+        double t_exit = t;
+        const double center[2] = {cx, cy};
+        const double o[2] = {origin.x(), origin.y()};
+        const double d[2] = {direction.x(), direction.y()};
+        for (int axis = 0; axis < 2 && t_enter <= t_exit; ++axis) {
+            const double lo = center[axis] - pillar_half_size - o[axis];
+            const double hi = center[axis] + pillar_half_size - o[axis];
+            if (d[axis] == 0.0) {
+                if (lo > 0.0 || hi < 0.0) {
+                    t_enter = t_exit + 1.0;
+                }
+                continue;
+            }
+            const double t0 = lo / d[axis];
+            const double t1 = hi / d[axis];
+            t_enter = std::max(t_enter, std::min(t0, t1));
+            t_exit = std::min(t_exit, std::max(t0, t1));
+        }
+        if (t_enter <= t_exit && t_enter > 0.0) {
+            t = t_enter;
+        }
+    }
+    return t;
+}
+
+void vdbfusion::RenderScan(const SyntheticScene& scene,
+                           const SyntheticSensor& sensor,
+                           const Sophus::SE3d& T_world_sensor,
+                           const ros::Time& stamp,
+                           uint32_t seed,
+                           sensor_msgs::PointCloud2& pcd) {
+    // Padded to 16 bytes like most drivers
+    constexpr uint32_t kPointStep = 16;
+    pcd.header.stamp = stamp;
+    pcd.height = sensor.rows;
+    pcd.width = sensor.columns;
+    pcd.fields.resize(3);
+    const char* names[3] = {"x", "y", "z"};
+    for (uint32_t i = 0; i < 3; ++i) {
+        pcd.fields[i].name = names[i];
+        pcd.fields[i].offset = 4 * i;
+        pcd.fields[i].datatype = sensor_msgs::PointField::FLOAT32;
+        pcd.fields[i].count = 1;
+    }
+    pcd.is_bigendian = false;
+    pcd.point_step = kPointStep;
+    pcd.row_step = kPointStep * pcd.width;
+    pcd.is_dense = false;
+    pcd.data.assign(static_cast<size_t>(pcd.row_step) * pcd.height, 0);
+
+    const Eigen::Matrix3d R = T_world_sensor.rotationMatrix();
+    const Eigen::Vector3d& origin = T_world_sensor.translation();
+    const float nan = std::numeric_limits<float>::quiet_NaN();
+    for (int row = 0; row < sensor.rows; ++row) {
+        for (int column = 0; column < sensor.columns; ++column) {
+            const Eigen::Vector3d direction = RayDirection(sensor, row, column);
+            const uint32_t ray = static_cast<uint32_t>(row * sensor.columns + column);
+            const double range = scene.Cast(origin, R * direction, sensor.max_range);
+            float point[3] = {nan, nan, nan};
+            if (range < sensor.max_range) {
+                const Eigen::Vector3f p =
+                    (direction * (range + sensor.range_noise * Noise(seed, ray))).cast<float>();
+                point[0] = p.x();
+                point[1] = p.y();
+                point[2] = p.z();
+            }
+            std::memcpy(&pcd.data[static_cast<size_t>(ray) * kPointStep], point, sizeof(point));
+        }
+    }
+}
+
+Sophus::SE3d vdbfusion::CorridorPose(const SyntheticScene& scene, double t, double speed) {
+    const double sway = 0.15 * scene.half_width;
+    const double y = sway * std::sin(0.2 * t);
+    const double yaw = 0.3 * std::sin(0.1 * t);
+    const double z = 0.4 * scene.height;
+    return {Eigen::Quaterniond(Eigen::AngleAxisd(yaw, Eigen::Vector3d::UnitZ())),
+            Eigen::Vector3d(speed * t, y, z)};
+}
@@ -24,126 +24,226 @@
 
 #include <geometry_msgs/TransformStamped.h>
 #include <ros/ros.h>
-#include <sensor_msgs/PointCloud.h>
-#include <sensor_msgs/point_cloud_conversion.h>
-#include <tf/transform_listener.h>
-#include <tf2_sensor_msgs/tf2_sensor_msgs.h>
 
 #include <Eigen/Core>
+#include <string>
 #include <vector>
 
-#include "igl/write_triangle_mesh.h"
+#include "LeafPool.hpp"
+#include "Log.hpp"
+#include "Mapper.hpp"
+#include "MapperMsgs.hpp"
+#include "MapperParams.hpp"
+#include "RosParams.hpp"
+#include "PipelineStats.hpp"
+#include "Sharding.hpp"
 #include "openvdb/openvdb.h"
 
 namespace {
-std::vector<Eigen::Vector3d> pcl2SensorMsgToEigen(const sensor_msgs::PointCloud2& pcl2) {
-    std::vector<Eigen::Vector3d> points;
-    points.reserve(pcl2.width);
-    sensor_msgs::PointCloud pcl;
-    sensor_msgs::convertPointCloud2ToPointCloud(pcl2, pcl);
-    std::for_each(pcl.points.begin(), pcl.points.end(), [&](const auto& point) {
-        points.emplace_back(Eigen::Vector3d(point.x, point.y, point.z));
-    });
-    return points;
-}
-
-void PreProcessCloud(std::vector<Eigen::Vector3d>& points, float min_range, float max_range) {
-    points.erase(
-        std::remove_if(points.begin(), points.end(), [&](auto p) { return p.norm() > max_range; }),
-        points.end());
-    points.erase(
-        std::remove_if(points.begin(), points.end(), [&](auto p) { return p.norm() < min_range; }),
-        points.end());
+ros::NodeHandle NodeHandleWithQueue(ros::CallbackQueue& queue) {
+    ros::NodeHandle nh;
+    nh.setCallbackQueue(&queue);
+    return nh;
 }
 }  // namespace
 
-vdbfusion::VDBVolume vdbfusion::VDBVolumeNode::InitVDBVolume() {
-    float voxel_size;
-    float sdf_trunc;
-    bool space_carving;
-
-    nh_.getParam("/voxel_size", voxel_size);
-    nh_.getParam("/sdf_trunc", sdf_trunc);
-    nh_.getParam("/space_carving", space_carving);
-
-    VDBVolume vdb_volume(voxel_size, sdf_trunc, space_carving);
-
-    return vdb_volume;
-}
-
-vdbfusion::VDBVolumeNode::VDBVolumeNode() : vdb_volume_(InitVDBVolume()), tf_(nh_) {
-    openvdb::initialize();
+vdbfusion::VDBVolumeNode::VDBVolumeNode()
+    : scan_nh_(NodeHandleWithQueue(scan_queue_)),
+      pose_nh_(NodeHandleWithQueue(pose_queue_)),
+      service_nh_(NodeHandleWithQueue(service_queue_)),
+      tf_(pose_nh_),
+      mapper_(ReadMapperConfig(RosParams(nh_))) {
+    const auto& config = mapper_.config();
 
     std::string pcl_topic;
     nh_.getParam("/pcl_topic", pcl_topic);
-    nh_.getParam("/preprocess", preprocess_);
-    nh_.getParam("/apply_pose", apply_pose_);
-    nh_.getParam("/min_range", min_range_);
-    nh_.getParam("/max_range", max_range_);
-
-    nh_.getParam("/fill_holes", fill_holes_);
-    nh_.getParam("/min_weight", min_weight_);
 
     int32_t tol;
     nh_.getParam("/timestamp_tolerance_ns", tol);
     timestamp_tolerance_ = ros::Duration(0, tol);
 
+    // A shard only integrates the points the router forwards to it, and saves its own volume
+    std::string save_service = "/save_vdb_volume";
+    int shard_id;
+    ros::NodeHandle("~").param("shard_id", shard_id, -1);
+    if (shard_id >= 0) {
+        pcl_topic = ShardNamespace(shard_id) + "/points";
+        save_service = ShardNamespace(shard_id) + save_service;
+    }
+
     const int queue_size = 500;
 
-    sub_ = nh_.subscribe(pcl_topic, queue_size, &vdbfusion::VDBVolumeNode::Integrate, this);
-    srv_ = nh_.advertiseService("/save_vdb_volume", &vdbfusion::VDBVolumeNode::saveVDBVolume, this);
+    sub_ = scan_nh_.subscribe(pcl_topic, queue_size, &vdbfusion::VDBVolumeNode::Integrate, this);
+    if (config.pose_corrections) {
+        std::string correction_topic;
+        nh_.param("/correction_topic", correction_topic, std::string("/corrected_path"));
+        correction_sub_ = pose_nh_.subscribe(correction_topic, 1,
+                                             &vdbfusion::VDBVolumeNode::CorrectPoses, this);
+    }
+    srv_ = service_nh_.advertiseService(save_service, &vdbfusion::VDBVolumeNode::saveVDBVolume,
+                                        this);
+
+    ROS_INFO_STREAM("Use '" << save_service << "' service to save the integrated volume");
+
+    // Leaves changed since the last delta are streamed at a fixed rate, nearest to the sensor first
+    if (config.stream_deltas) {
+        double period;
+        double budget_kbps;
+        nh_.param("/stream_period", period, 1.0);
+        nh_.param("/stream_budget_kbps", budget_kbps, 0.0);
+        nh_.param("/parent_frame", delta_.header.frame_id, std::string());
+        stream_budget_bytes_ = static_cast<size_t>(budget_kbps * 1000.0 / 8.0 * period);
+        delta_pub_ = nh_.advertise<vdbfusion_ros::VolumeDelta>("/volume_delta", queue_size);
+        resync_sub_ = service_nh_.subscribe("/volume_delta/resync", 1,
+                                            &vdbfusion::VDBVolumeNode::Resync, this);
+        stream_timer_ = service_nh_.createTimer(ros::Duration(period),
+                                                &vdbfusion::VDBVolumeNode::PublishDelta, this);
+    }
+
+    // Low weight leaves that stopped receiving updates are dropped in a periodic pass
+    if (config.eviction) {
+        eviction_timer_ = service_nh_.createTimer(ros::Duration(config.eviction_period),
+                                                  &vdbfusion::VDBVolumeNode::EvictTransients,
+                                                  this);
+    }
+
+    // Per-stage totals, with the hardware counters if the Mapper could enable them
+    double metrics_period;
+    nh_.param("/metrics_period", metrics_period, 0.0);
+    if (metrics_period > 0.0) {
+        metrics_pub_ = nh_.advertise<vdbfusion_ros::PipelineMetrics>("/pipeline_metrics", 1);
+        metrics_timer_ = service_nh_.createTimer(ros::Duration(metrics_period),
+                                                 &vdbfusion::VDBVolumeNode::PublishMetrics, this);
+    }
 
-    ROS_INFO("Use '/save_vdb_volume' service to save the integrated volume");
+    int scan_threads;
+    int pose_threads;
+    int service_threads;
+    nh_.param("/scan_threads", scan_threads, 1);
+    nh_.param("/pose_threads", pose_threads, 1);
+    nh_.param("/service_threads", service_threads, 1);
+    // Decoding, filtering and integration all run on the per-scan buffers of the mapper under its
+    // lock, a second scan thread would only wait for it. Scans would then be taken out of order,
+    // and the pose buffer drops the poses older than every lookup.
+    if (scan_threads != 1) {
+        ROS_WARN("scan_threads is %d, scans are processed by a single thread to keep them in order",
+                 scan_threads);
+        scan_threads = 1;
+    }
+    spinners_.push_back(std::make_unique<ros::AsyncSpinner>(scan_threads, &scan_queue_));
+    spinners_.push_back(std::make_unique<ros::AsyncSpinner>(pose_threads, &pose_queue_));
+    spinners_.push_back(std::make_unique<ros::AsyncSpinner>(service_threads, &service_queue_));
+    for (auto& spinner : spinners_) {
+        spinner->start();
+    }
+}
+
+vdbfusion::VDBVolumeNode::~VDBVolumeNode() {
+    // The spinner threads must be done with the callbacks before the members go away
+    for (auto& spinner : spinners_) {
+        spinner->stop();
+    }
+    ROS_INFO_STREAM("Pipeline stages:\n" << FormatSummary(mapper_.Stats()));
 }
 
 void vdbfusion::VDBVolumeNode::Integrate(const sensor_msgs::PointCloud2& pcd) {
     geometry_msgs::TransformStamped transform;
-    sensor_msgs::PointCloud2 pcd_out;
 
     if (tf_.lookUpTransform(pcd.header.stamp, timestamp_tolerance_, transform)) {
         ROS_INFO("Transform available");
-        if (apply_pose_) {
-            tf2::doTransform(pcd, pcd_out, transform);
-        }
-        auto scan = pcl2SensorMsgToEigen(pcd_out);
+        IntegrateCloud(mapper_, pcd, TransformToSE3(transform.transform));
+    }
+}
+
+void vdbfusion::VDBVolumeNode::CorrectPoses(const nav_msgs::Path& path) {
+    std::vector<PoseCorrection> corrections;
+    corrections.reserve(path.poses.size());
+    for (const auto& pose : path.poses) {
+        const auto& p = pose.pose.position;
+        const auto& q = pose.pose.orientation;
+        corrections.push_back({pose.header.stamp.toSec(),
+                               Sophus::SE3d(Eigen::Quaterniond(q.w, q.x, q.y, q.z).normalized(),
+                                            Eigen::Vector3d(p.x, p.y, p.z))});
+    }
+    mapper_.CorrectPoses(corrections);
+}
 
-        if (preprocess_) {
-            PreProcessCloud(scan, min_range_, max_range_);
+void vdbfusion::VDBVolumeNode::EvictTransients(const ros::TimerEvent& /*unused*/) {
+    using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+    const EvictionStats stats = mapper_.EvictTransients();
+    if (stats.evicted_leaves == 0) {
+        return;
+    }
+    const double freed_mb = static_cast<double>(stats.evicted_leaves) * 2.0 *
+                            (sizeof(LeafT) + LeafT::SIZE * sizeof(float)) / (1 << 20);
+    ROS_INFO("Evicted %zu transient leaves (%zu voxels, ~%.1f MB), %zu leaves left",
+             stats.evicted_leaves, stats.evicted_voxels, freed_mb, stats.remaining_leaves);
+}
+
+void vdbfusion::VDBVolumeNode::PublishDelta(const ros::TimerEvent& /*unused*/) {
+    if (!mapper_.EncodeDelta(stream_budget_bytes_, delta_)) {
+        return;
+    }
+    SwapIntoMsg(delta_, delta_msg_);
+    delta_msg_.header.stamp = ros::Time::now();
+    delta_pub_.publish(delta_msg_);
+}
+
+void vdbfusion::VDBVolumeNode::Resync(const std_msgs::Empty& /*unused*/) {
+    ROS_INFO("Resync requested, streaming the whole volume again");
+    mapper_.ResetDeltas();
+}
+
+void vdbfusion::VDBVolumeNode::PublishMetrics(const ros::TimerEvent& /*unused*/) {
+    const PipelineStats stats = mapper_.Stats();
+    const bool with_counters = mapper_.config().hardware_counters;
+    vdbfusion_ros::PipelineMetrics metrics;
+    metrics.header.stamp = ros::Time::now();
+    for (size_t i = 0; i < kStageCount; ++i) {
+        const auto& stage = stats[static_cast<Stage>(i)];
+        metrics.stages.emplace_back(StageName(static_cast<Stage>(i)));
+        metrics.calls.push_back(stage.calls);
+        metrics.seconds.push_back(stage.seconds);
+        if (!with_counters) {
+            continue;
         }
-        const auto& x = transform.transform.translation.x;
-        const auto& y = transform.transform.translation.y;
-        const auto& z = transform.transform.translation.z;
-        auto origin = Eigen::Vector3d(x, y, z);
-        vdb_volume_.Integrate(scan, origin, [](float /*unused*/) { return 1.0; });
+        const auto count = [&](Counter counter) {
+            return stage.counters[static_cast<size_t>(counter)];
+        };
+        metrics.cycles.push_back(count(Counter::kCycles));
+        metrics.instructions.push_back(count(Counter::kInstructions));
+        metrics.llc_misses.push_back(count(Counter::kLLCMisses));
+        metrics.dtlb_misses.push_back(count(Counter::kDTLBMisses));
+        metrics.branch_misses.push_back(count(Counter::kBranchMisses));
     }
+    metrics_pub_.publish(metrics);
 }
 
 bool vdbfusion::VDBVolumeNode::saveVDBVolume(vdbfusion_ros::save_vdb_volume::Request& path,
                                              vdbfusion_ros::save_vdb_volume::Response& response) {
     ROS_INFO("Saving the mesh and VDB grid files ...");
-    std::string volume_name = path.path;
-    openvdb::io::File(volume_name + "_grid.vdb").write({vdb_volume_.tsdf_});
-
-    // Run marching cubes and save a .ply file
-    auto [vertices, triangles] =
-        this->vdb_volume_.ExtractTriangleMesh(this->fill_holes_, this->min_weight_);
-
-    Eigen::MatrixXd V(vertices.size(), 3);
-    for (size_t i = 0; i < vertices.size(); i++) {
-        V.row(i) = Eigen::VectorXd::Map(&vertices[i][0], vertices[i].size());
-    }
+    mapper_.Save(path.path);
+    ROS_INFO("Done saving the mesh and VDB grid files");
 
-    Eigen::MatrixXi F(triangles.size(), 3);
-    for (size_t i = 0; i < triangles.size(); i++) {
-        F.row(i) = Eigen::VectorXi::Map(&triangles[i][0], triangles[i].size());
+    ROS_INFO("Resident memory: %.1f MB", static_cast<double>(ResidentSetSize()) / (1 << 20));
+    if (LeafPool::Instance().Enabled()) {
+        const auto stats = LeafPool::Instance().Stats();
+        ROS_INFO("Leaf pool: %zu slabs, %zu live blocks, %zu allocations, %.3f s refilling",
+                 stats.slabs, stats.live_blocks, stats.allocations, stats.refill_seconds);
     }
-    igl::write_triangle_mesh(volume_name + "_mesh.ply", V, F, igl::FileEncoding::Binary);
-    ROS_INFO("Done saving the mesh and VDB grid files");
     return true;
 }
 
 int main(int argc, char** argv) {
     ros::init(argc, argv, "vdbfusion_rosnode");
+    // The Mapper reports its option checks while the node builds it
+    vdbfusion::SetLogSink([](vdbfusion::LogLevel level, const std::string& message) {
+        if (level == vdbfusion::LogLevel::kWarn) {
+            ROS_WARN("%s", message.c_str());
+        } else {
+            ROS_INFO("%s", message.c_str());
+        }
+    });
     vdbfusion::VDBVolumeNode vdb_volume_node;
-    ros::spin();
+    ros::waitForShutdown();
 }
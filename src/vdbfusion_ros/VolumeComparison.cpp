@@ -0,0 +1,116 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "VolumeComparison.hpp"
+
+#include <openvdb/openvdb.h>
+#include <openvdb/tools/Interpolation.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <tuple>
+#include <vector>
+
+#include "vdbfusion/VDBVolume.h"
+
+namespace {
+// Active voxels of source that are not active in other, and the squared tsdf differences of the
+// ones that are
+size_t CountMissing(const openvdb::FloatGrid& source,
+                    const openvdb::FloatGrid& other,
+                    double* squared_difference) {
+    const auto other_acc = other.getConstAccessor();
+    size_t missing = 0;
+    for (auto iter = source.cbeginValueOn(); iter; ++iter) {
+        float value;
+        if (!other_acc.probeValue(iter.getCoord(), value)) {
+            ++missing;
+        } else if (squared_difference) {
+            const double difference = static_cast<double>(*iter) - value;
+            *squared_difference += difference * difference;
+        }
+    }
+    return missing;
+}
+
+// Distance of every vertex to the zero crossing of the surface tsdf, trilinearly interpolated
+// between its active voxels
+void SurfaceDistances(const std::vector<Eigen::Vector3d>& vertices,
+                      const vdbfusion::VDBVolume& surface,
+                      std::vector<double>& distances,
+                      size_t& unmatched) {
+    const auto acc = surface.tsdf_->getConstAccessor();
+    const auto& xform = surface.tsdf_->transform();
+    for (const auto& vertex : vertices) {
+        const openvdb::Vec3d index = xform.worldToIndex(openvdb::Vec3d(vertex.data()));
+        float tsdf;
+        if (!openvdb::tools::BoxSampler::sample(acc, index, tsdf) ||
+            std::abs(tsdf) >= surface.sdf_trunc_) {
+            ++unmatched;
+            continue;
+        }
+        distances.push_back(std::abs(tsdf));
+    }
+}
+}  // namespace
+
+vdbfusion::VolumeComparison vdbfusion::CompareVolumes(const VDBVolume& result,
+                                                      const VDBVolume& reference,
+                                                      bool fill_holes,
+                                                      float min_weight) {
+    VolumeComparison comparison;
+    double squared_difference = 0.0;
+    comparison.only_in_result = CountMissing(*result.tsdf_, *reference.tsdf_, &squared_difference);
+    comparison.only_in_reference = CountMissing(*reference.tsdf_, *result.tsdf_, nullptr);
+    comparison.common_voxels = result.tsdf_->activeVoxelCount() - comparison.only_in_result;
+    const size_t n_union =
+        comparison.common_voxels + comparison.only_in_result + comparison.only_in_reference;
+    comparison.jaccard =
+        n_union > 0 ? static_cast<double>(comparison.common_voxels) / n_union : 1.0;
+    comparison.tsdf_rms = comparison.common_voxels > 0
+                              ? std::sqrt(squared_difference / comparison.common_voxels)
+                              : 0.0;
+
+    const auto result_vertices = std::get<0>(result.ExtractTriangleMesh(fill_holes, min_weight));
+    const auto reference_vertices =
+        std::get<0>(reference.ExtractTriangleMesh(fill_holes, min_weight));
+    std::vector<double> distances;
+    distances.reserve(result_vertices.size() + reference_vertices.size());
+    SurfaceDistances(result_vertices, reference, distances, comparison.unmatched_vertices);
+    SurfaceDistances(reference_vertices, result, distances, comparison.unmatched_vertices);
+    comparison.vertices = result_vertices.size() + reference_vertices.size();
+    if (!distances.empty()) {
+        double sum = 0.0;
+        for (const double distance : distances) {
+            sum += distance;
+        }
+        comparison.chamfer_mean = sum / distances.size();
+        const auto p95 = distances.begin() + static_cast<std::ptrdiff_t>(
+                                                 0.95 * static_cast<double>(distances.size() - 1));
+        std::nth_element(distances.begin(), p95, distances.end());
+        comparison.chamfer_p95 = *p95;
+    }
+    return comparison;
+}
@@ -0,0 +1,232 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "VolumeIO.hpp"
+
+#include <openvdb/openvdb.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "igl/write_triangle_mesh.h"
+#include "sophus/se3.hpp"
+
+namespace {
+// Names given to the grids by vdbfusion::VDBVolume
+constexpr const char* kTsdfGridName = "D(x): signed distance grid";
+constexpr const char* kWeightsGridName = "W(x): weights grid";
+
+// Weights of a file written before the weights grid was saved: every active tsdf voxel counts as
+// a single observation
+openvdb::FloatGrid::Ptr UnitWeights(const openvdb::FloatGrid& tsdf) {
+    auto weights = openvdb::FloatGrid::create(0.0f);
+    weights->setName(kWeightsGridName);
+    weights->setTransform(tsdf.transform().copy());
+    weights->tree().topologyUnion(tsdf.tree());
+    for (auto value = weights->beginValueOn(); value; ++value) {
+        value.setValue(1.0f);
+    }
+    return weights;
+}
+}  // namespace
+
+void vdbfusion::SaveVDBVolume(const VDBVolume& volume,
+                              const std::string& prefix,
+                              bool fill_holes,
+                              float min_weight) {
+    openvdb::io::File(prefix + "_grid.vdb").write({volume.tsdf_, volume.weights_});
+
+    // Run marching cubes and save a .ply file
+    auto [vertices, triangles] = volume.ExtractTriangleMesh(fill_holes, min_weight);
+
+    Eigen::MatrixXd V(vertices.size(), 3);
+    for (size_t i = 0; i < vertices.size(); i++) {
+        V.row(i) = Eigen::VectorXd::Map(&vertices[i][0], vertices[i].size());
+    }
+
+    Eigen::MatrixXi F(triangles.size(), 3);
+    for (size_t i = 0; i < triangles.size(); i++) {
+        F.row(i) = Eigen::VectorXi::Map(&triangles[i][0], triangles[i].size());
+    }
+    igl::write_triangle_mesh(prefix + "_mesh.ply", V, F, igl::FileEncoding::Binary);
+}
+
+std::optional<vdbfusion::VDBVolume> vdbfusion::LoadVDBVolume(const std::string& filename) {
+    openvdb::io::File file(filename);
+    try {
+        file.open();
+    } catch (const openvdb::IoError&) {
+        return std::nullopt;
+    }
+    if (!file.hasGrid(kTsdfGridName)) {
+        return std::nullopt;
+    }
+    auto tsdf = openvdb::gridPtrCast<openvdb::FloatGrid>(file.readGrid(kTsdfGridName));
+    openvdb::FloatGrid::Ptr weights;
+    if (file.hasGrid(kWeightsGridName)) {
+        weights = openvdb::gridPtrCast<openvdb::FloatGrid>(file.readGrid(kWeightsGridName));
+    } else if (tsdf) {
+        weights = UnitWeights(*tsdf);
+    }
+    file.close();
+    if (!tsdf || !weights) {
+        return std::nullopt;
+    }
+
+    const auto voxel_size = static_cast<float>(tsdf->voxelSize()[0]);
+    VDBVolume volume(voxel_size, tsdf->background(), false);
+    volume.tsdf_ = tsdf;
+    volume.weights_ = weights;
+    return volume;
+}
+
+bool vdbfusion::MergeVolume(VDBVolume& target,
+                            const VDBVolume& source,
+                            const Sophus::SE3d& T_target_source) {
+    using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+    if (target.weights_->voxelSize() != source.weights_->voxelSize()) {
+        return false;
+    }
+    const auto& xform = target.tsdf_->transform();
+    const double voxel_size = target.voxel_size_;
+    const bool aligned = T_target_source.matrix().isIdentity(0.0);
+    const Sophus::SE3d T_source_target = T_target_source.inverse();
+
+    // Candidate leaves: the source leaves themselves when the frames agree, otherwise every target
+    // leaf overlapping the transformed bounding box of a source leaf, grown by one voxel for the
+    // interpolation stencil
+    const openvdb::Int32 leaf_mask = ~static_cast<openvdb::Int32>(LeafT::DIM - 1);
+    std::vector<openvdb::Coord> leaf_origins;
+    for (auto leaf = source.weights_->tree().cbeginLeaf(); leaf; ++leaf) {
+        if (aligned) {
+            leaf_origins.emplace_back(leaf->origin());
+            continue;
+        }
+        openvdb::Vec3d min(std::numeric_limits<double>::max());
+        openvdb::Vec3d max(std::numeric_limits<double>::lowest());
+        for (int corner = 0; corner < 8; ++corner) {
+            const openvdb::Coord ijk = leaf->origin().offsetBy((corner & 1) ? LeafT::DIM : 0,
+                                                               (corner & 2) ? LeafT::DIM : 0,
+                                                               (corner & 4) ? LeafT::DIM : 0);
+            const openvdb::Vec3d p = xform.indexToWorld(ijk);
+            const Eigen::Vector3d q = T_target_source * Eigen::Vector3d(p.x(), p.y(), p.z());
+            const openvdb::Vec3d index = xform.worldToIndex(openvdb::Vec3d(q.x(), q.y(), q.z()));
+            min = openvdb::math::minComponent(min, index);
+            max = openvdb::math::maxComponent(max, index);
+        }
+        const openvdb::Coord lo = openvdb::Coord::floor(min).offsetBy(-1);
+        const openvdb::Coord hi = openvdb::Coord::floor(max).offsetBy(1);
+        for (openvdb::Int32 x = lo.x() & leaf_mask; x <= hi.x(); x += LeafT::DIM) {
+            for (openvdb::Int32 y = lo.y() & leaf_mask; y <= hi.y(); y += LeafT::DIM) {
+                for (openvdb::Int32 z = lo.z() & leaf_mask; z <= hi.z(); z += LeafT::DIM) {
+                    leaf_origins.emplace_back(x, y, z);
+                }
+            }
+        }
+    }
+    std::sort(leaf_origins.begin(), leaf_origins.end());
+    leaf_origins.erase(std::unique(leaf_origins.begin(), leaf_origins.end()), leaf_origins.end());
+
+    // Topology changes are not thread safe, allocate all the candidate leaves upfront
+    auto& tsdf_tree = target.tsdf_->tree();
+    auto& weights_tree = target.weights_->tree();
+    const size_t n_leaves = leaf_origins.size();
+    std::vector<LeafT*> tsdf_leaves(n_leaves);
+    std::vector<LeafT*> weights_leaves(n_leaves);
+    std::vector<uint8_t> created(n_leaves);
+    for (size_t i = 0; i < n_leaves; ++i) {
+        created[i] = tsdf_tree.probeLeaf(leaf_origins[i]) == nullptr;
+        tsdf_leaves[i] = tsdf_tree.touchLeaf(leaf_origins[i]);
+        weights_leaves[i] = weights_tree.touchLeaf(leaf_origins[i]);
+    }
+
+    // Each leaf is owned by a single task, the source is only read through per-task accessors
+    std::vector<size_t> n_updates(n_leaves, 0);
+    tbb::parallel_for(tbb::blocked_range<size_t>(0, n_leaves), [&](const auto& range) {
+        auto source_tsdf = source.tsdf_->getConstAccessor();
+        auto source_weights = source.weights_->getConstAccessor();
+        for (size_t i = range.begin(); i != range.end(); ++i) {
+            LeafT* tsdf_leaf = tsdf_leaves[i];
+            LeafT* weights_leaf = weights_leaves[i];
+            for (openvdb::Index offset = 0; offset < LeafT::SIZE; ++offset) {
+                const openvdb::Coord voxel = tsdf_leaf->offsetToGlobalCoord(offset);
+                float source_weight = 0.0f;
+                float source_tsdf_sum = 0.0f;
+                if (aligned) {
+                    if (source_weights.isValueOn(voxel)) {
+                        source_weight = source_weights.getValue(voxel);
+                        source_tsdf_sum = source_tsdf.getValue(voxel) * source_weight;
+                    }
+                } else {
+                    // Voxel values live at the voxel centers
+                    const openvdb::Vec3d center = xform.indexToWorld(voxel) + voxel_size / 2.0;
+                    const Eigen::Vector3d q =
+                        T_source_target * Eigen::Vector3d(center.x(), center.y(), center.z());
+                    const openvdb::Vec3d index = xform.worldToIndex(
+                        openvdb::Vec3d(q.x(), q.y(), q.z()) - voxel_size / 2.0);
+                    const openvdb::Coord base = openvdb::Coord::floor(index);
+                    const openvdb::Vec3d frac = index - base.asVec3d();
+                    for (int corner = 0; corner < 8; ++corner) {
+                        const openvdb::Coord ijk = base.offsetBy(corner & 1, (corner >> 1) & 1,
+                                                                 (corner >> 2) & 1);
+                        float weight;
+                        if (!source_weights.probeValue(ijk, weight)) {
+                            continue;
+                        }
+                        const double b = ((corner & 1) ? frac.x() : 1.0 - frac.x()) *
+                                         ((corner & 2) ? frac.y() : 1.0 - frac.y()) *
+                                         ((corner & 4) ? frac.z() : 1.0 - frac.z());
+                        const float sample_weight = static_cast<float>(b) * weight;
+                        source_weight += sample_weight;
+                        source_tsdf_sum += sample_weight * source_tsdf.getValue(ijk);
+                    }
+                }
+                if (source_weight <= 0.0f) {
+                    continue;
+                }
+                const float last_weight = weights_leaf->getValue(offset);
+                const float last_tsdf = tsdf_leaf->getValue(offset);
+                const float new_weight = last_weight + source_weight;
+                const float new_tsdf = (last_tsdf * last_weight + source_tsdf_sum) / new_weight;
+                tsdf_leaf->setValueOn(offset, new_tsdf);
+                weights_leaf->setValueOn(offset, new_weight);
+                ++n_updates[i];
+            }
+        }
+    });
+
+    // Drop the leaves we allocated but that did not receive a single sample
+    for (size_t i = 0; i < n_leaves; ++i) {
+        if (created[i] && n_updates[i] == 0) {
+            delete tsdf_tree.stealNode<LeafT>(leaf_origins[i], tsdf_tree.background(), false);
+            delete weights_tree.stealNode<LeafT>(leaf_origins[i], weights_tree.background(), false);
+        }
+    }
+    return true;
+}
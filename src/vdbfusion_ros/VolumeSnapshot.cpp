@@ -0,0 +1,155 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "VolumeSnapshot.hpp"
+
+#include <openvdb/openvdb.h>
+
+#include <algorithm>
+#include <iterator>
+#include <memory>
+#include <vector>
+
+const vdbfusion::SnapshotLeaf* vdbfusion::VolumeSnapshot::FindLeaf(
+    const openvdb::Coord& origin) const {
+    const auto it = std::lower_bound(origins_.cbegin(), origins_.cend(), origin);
+    if (it == origins_.cend() || *it != origin) {
+        return nullptr;
+    }
+    return leaves_[it - origins_.cbegin()].get();
+}
+
+vdbfusion::VDBVolume vdbfusion::VolumeSnapshot::ToVDBVolume() const {
+    VDBVolume volume(voxel_size_, sdf_trunc_, false);
+    auto& tsdf_tree = volume.tsdf_->tree();
+    auto& weights_tree = volume.weights_->tree();
+    for (const auto& leaf : leaves_) {
+        tsdf_tree.addLeaf(new SnapshotLeaf::LeafT(leaf->tsdf));
+        weights_tree.addLeaf(new SnapshotLeaf::LeafT(leaf->weights));
+    }
+    return volume;
+}
+
+namespace {
+void SortUnique(std::vector<openvdb::Coord>& origins) {
+    std::sort(origins.begin(), origins.end());
+    origins.erase(std::unique(origins.begin(), origins.end()), origins.end());
+}
+}  // namespace
+
+void vdbfusion::SnapshotWriter::MarkDirty(const std::vector<openvdb::Coord>& origins) {
+    // Without a previous snapshot the next one copies every leaf anyway
+    if (origins.empty() || last_.expired()) {
+        return;
+    }
+    dirty_.insert(dirty_.end(), origins.cbegin(), origins.cend());
+    // Bounded by twice the touched leaves, however long no snapshot is taken
+    if (dirty_.size() > 2 * compacted_ + 1024) {
+        SortUnique(dirty_);
+        compacted_ = dirty_.size();
+    }
+}
+
+template <typename ListLeaves, typename CopyLeaf>
+std::shared_ptr<const vdbfusion::VolumeSnapshot> vdbfusion::SnapshotWriter::Take(
+    float voxel_size, float sdf_trunc, const ListLeaves& list_leaves, const CopyLeaf& copy_leaf) {
+    using LeafT = SnapshotLeaf::LeafT;
+    const std::shared_ptr<const VolumeSnapshot> last = last_.lock();
+    if (last && dirty_.empty()) {
+        return last;
+    }
+    // Nothing left to share with, every leaf is copied
+    if (!last) {
+        dirty_.clear();
+        list_leaves(dirty_);
+    }
+    SortUnique(dirty_);
+
+    auto snapshot = std::make_shared<VolumeSnapshot>();
+    snapshot->version_ = ++version_;
+    snapshot->voxel_size_ = voxel_size;
+    snapshot->sdf_trunc_ = sdf_trunc;
+    const size_t n_last = last ? last->origins_.size() : 0;
+    snapshot->origins_.reserve(n_last + dirty_.size());
+    snapshot->leaves_.reserve(n_last + dirty_.size());
+
+    // Both lists are sorted by origin: clean leaves are shared, dirty ones copied or dropped
+    size_t i = 0;
+    for (const auto& origin : dirty_) {
+        for (; i < n_last && last->origins_[i] < origin; ++i) {
+            snapshot->origins_.push_back(last->origins_[i]);
+            snapshot->leaves_.push_back(last->leaves_[i]);
+        }
+        if (i < n_last && last->origins_[i] == origin) {
+            ++i;
+        }
+        auto leaf = std::make_shared<SnapshotLeaf>(
+            SnapshotLeaf{LeafT(origin, sdf_trunc), LeafT(origin, 0.0f)});
+        if (copy_leaf(*leaf)) {
+            snapshot->origins_.push_back(origin);
+            snapshot->leaves_.push_back(std::move(leaf));
+        }
+    }
+    for (; i < n_last; ++i) {
+        snapshot->origins_.push_back(last->origins_[i]);
+        snapshot->leaves_.push_back(last->leaves_[i]);
+    }
+
+    dirty_.clear();
+    compacted_ = 0;
+    last_ = snapshot;
+    if (retain_) {
+        retained_ = snapshot;
+    }
+    return snapshot;
+}
+
+std::shared_ptr<const vdbfusion::VolumeSnapshot> vdbfusion::SnapshotWriter::Take(
+    const VDBVolume& volume) {
+    const auto& tsdf_tree = volume.tsdf_->tree();
+    const auto& weights_tree = volume.weights_->tree();
+    const auto list_leaves = [&](std::vector<openvdb::Coord>& origins) {
+        for (auto leaf = weights_tree.cbeginLeaf(); leaf; ++leaf) {
+            origins.push_back(leaf->origin());
+        }
+    };
+    return Take(volume.voxel_size_, volume.sdf_trunc_, list_leaves, [&](SnapshotLeaf& leaf) {
+        const auto* tsdf = tsdf_tree.probeConstLeaf(leaf.tsdf.origin());
+        const auto* weights = weights_tree.probeConstLeaf(leaf.tsdf.origin());
+        if (tsdf == nullptr || weights == nullptr) {
+            return false;
+        }
+        leaf.tsdf = *tsdf;
+        leaf.weights = *weights;
+        return true;
+    });
+}
+
+std::shared_ptr<const vdbfusion::VolumeSnapshot> vdbfusion::SnapshotWriter::Take(
+    const FusedVolumeBase& volume) {
+    const auto list_leaves = [&](std::vector<openvdb::Coord>& origins) {
+        volume.LeafOrigins(origins);
+    };
+    return Take(volume.voxel_size_, volume.sdf_trunc_, list_leaves, [&](SnapshotLeaf& leaf) {
+        return volume.CopyLeaf(leaf.tsdf, leaf.weights);
+    });
+}
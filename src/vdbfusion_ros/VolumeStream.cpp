@@ -0,0 +1,250 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "VolumeStream.hpp"
+
+#include <blosc.h>
+#include <openvdb/io/Compression.h>
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cstring>
+#include <iterator>
+#include <mutex>
+#include <vector>
+
+namespace {
+using LeafT = openvdb::FloatGrid::TreeType::LeafNodeType;
+using MaskT = LeafT::NodeMaskType;
+
+// {value mask, tsdf values, weights}, the inactive values are background and compress away
+constexpr size_t kMaskBytes = MaskT::WORD_COUNT * sizeof(MaskT::Word);
+constexpr size_t kValueBytes = LeafT::SIZE * sizeof(float);
+constexpr size_t kRecordBytes = kMaskBytes + 2 * kValueBytes;
+
+void WriteRecord(const LeafT& tsdf, const LeafT& weights, char* record) {
+    const MaskT& mask = weights.getValueMask();
+    for (openvdb::Index n = 0; n < MaskT::WORD_COUNT; ++n) {
+        const MaskT::Word word = mask.getWord<MaskT::Word>(n);
+        std::memcpy(record + n * sizeof(MaskT::Word), &word, sizeof(MaskT::Word));
+    }
+    std::memcpy(record + kMaskBytes, tsdf.buffer().data(), kValueBytes);
+    std::memcpy(record + kMaskBytes + kValueBytes, weights.buffer().data(), kValueBytes);
+}
+
+void ReadRecord(const char* record, LeafT& tsdf, LeafT& weights) {
+    MaskT mask;
+    for (openvdb::Index n = 0; n < MaskT::WORD_COUNT; ++n) {
+        std::memcpy(&mask.getWord<MaskT::Word>(n), record + n * sizeof(MaskT::Word),
+                    sizeof(MaskT::Word));
+    }
+    std::memcpy(tsdf.buffer().data(), record + kMaskBytes, kValueBytes);
+    std::memcpy(weights.buffer().data(), record + kMaskBytes + kValueBytes, kValueBytes);
+    tsdf.setValueMask(mask);
+    weights.setValueMask(mask);
+}
+}  // namespace
+
+void vdbfusion::LeafDeltaEncoder::Reset() {
+    sent_.clear();
+    full_ = true;
+}
+
+void vdbfusion::LeafDeltaEncoder::MarkDirty(const std::vector<openvdb::Coord>& origins) {
+    std::lock_guard<std::mutex> lock(pending_mutex_);
+    pending_.insert(pending_.end(), origins.begin(), origins.end());
+}
+
+void vdbfusion::LeafDeltaEncoder::Collect(const VDBVolume& volume,
+                                          const Eigen::Vector3d& position) {
+    voxel_size_ = volume.voxel_size_;
+    sdf_trunc_ = volume.sdf_trunc_;
+    collected_.clear();
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        collected_.swap(pending_);
+    }
+    // A resend starts from every leaf, the only time the whole map is walked
+    if (full_) {
+        for (auto leaf = volume.weights_->tree().cbeginLeaf(); leaf; ++leaf) {
+            collected_.push_back(leaf->origin());
+        }
+    }
+    std::sort(collected_.begin(), collected_.end());
+    collected_.erase(std::unique(collected_.begin(), collected_.end()), collected_.end());
+
+    // Touched leaves that still exist are copied, the ones the receiver holds but that are gone
+    // are removed. Reported leaves that were never allocated are neither.
+    const auto& tsdf_tree = volume.tsdf_->tree();
+    const auto& weights_tree = volume.weights_->tree();
+    const auto& xform = volume.weights_->transform();
+    const openvdb::Vec3d eye(position.x(), position.y(), position.z());
+    dirty_.clear();
+    removed_.clear();
+    records_.resize(collected_.size() * kRecordBytes);
+    for (const auto& origin : collected_) {
+        const LeafT* tsdf = tsdf_tree.probeConstLeaf(origin);
+        const LeafT* weights = weights_tree.probeConstLeaf(origin);
+        if (tsdf == nullptr || weights == nullptr) {
+            if (std::binary_search(sent_.begin(), sent_.end(), origin)) {
+                removed_.push_back(origin);
+            }
+            continue;
+        }
+        const size_t record = dirty_.size() * kRecordBytes;
+        WriteRecord(*tsdf, *weights, records_.data() + record);
+        const openvdb::Vec3d center =
+            xform.indexToWorld(origin.offsetBy(LeafT::DIM / 2).asVec3d());
+        dirty_.push_back({origin, (center - eye).lengthSqr(), record});
+    }
+}
+
+void vdbfusion::LeafDeltaEncoder::Encode(size_t budget_bytes, LeafDelta& delta) {
+    delta.voxel_size = voxel_size_;
+    delta.sdf_trunc = sdf_trunc_;
+    delta.removed_origins.clear();
+    delta.leaf_origins.clear();
+    delta.leaf_bytes.clear();
+    delta.data.clear();
+    for (const auto& origin : removed_) {
+        delta.removed_origins.insert(delta.removed_origins.end(),
+                                     {origin.x(), origin.y(), origin.z()});
+    }
+
+    // Nearest leaves first until the budget is spent
+    std::sort(dirty_.begin(), dirty_.end(), [](const DirtyLeaf& a, const DirtyLeaf& b) {
+        return a.distance2 < b.distance2;
+    });
+    const bool blosc = openvdb::io::bloscCanCompress();
+    compressed_.resize(kRecordBytes + 64);
+    updated_.clear();
+    size_t n_sent = 0;
+    for (; n_sent < dirty_.size(); ++n_sent) {
+        const char* record = records_.data() + dirty_[n_sent].record;
+        size_t bytes = 0;
+        if (blosc) {
+            openvdb::io::bloscCompress(compressed_.data(), bytes, compressed_.size(), record,
+                                       kRecordBytes);
+        }
+        // A record of the raw size is stored uncompressed
+        const bool use_compressed = bytes > 0 && bytes < kRecordBytes;
+        const char* data = use_compressed ? compressed_.data() : record;
+        bytes = use_compressed ? bytes : kRecordBytes;
+        if (budget_bytes > 0 && n_sent > 0 && delta.data.size() + bytes > budget_bytes) {
+            break;
+        }
+        const openvdb::Coord& origin = dirty_[n_sent].origin;
+        delta.leaf_origins.insert(delta.leaf_origins.end(), {origin.x(), origin.y(), origin.z()});
+        delta.leaf_bytes.push_back(static_cast<uint32_t>(bytes));
+        delta.data.insert(delta.data.end(), data, data + bytes);
+        updated_.push_back(origin);
+    }
+    // Leaves that did not fit are collected again for the next delta
+    if (n_sent < dirty_.size()) {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        for (size_t i = n_sent; i < dirty_.size(); ++i) {
+            pending_.push_back(dirty_[i].origin);
+        }
+    }
+
+    // The receiver now holds what it held, without the removed leaves, plus the sent ones.
+    // removed_ is sorted since it was collected in order.
+    std::sort(updated_.begin(), updated_.end());
+    collected_.clear();
+    std::set_difference(sent_.begin(), sent_.end(), removed_.begin(), removed_.end(),
+                        std::back_inserter(collected_));
+    sent_.clear();
+    std::set_union(collected_.begin(), collected_.end(), updated_.begin(), updated_.end(),
+                   std::back_inserter(sent_));
+
+    delta.full = full_;
+    if (full_ || !delta.leaf_bytes.empty() || !delta.removed_origins.empty()) {
+        ++version_;
+    }
+    full_ = false;
+    delta.version = version_;
+}
+
+bool vdbfusion::VolumeMirror::Apply(const LeafDelta& delta) {
+    // Every record is decoded before the mirror is touched, so a corrupt delta changes nothing
+    const size_t n_records = delta.leaf_bytes.size();
+    if (delta.leaf_origins.size() != 3 * n_records) {
+        return false;
+    }
+    records_.resize(n_records * kRecordBytes);
+    const bool blosc = openvdb::io::bloscCanCompress();
+    size_t offset = 0;
+    for (size_t i = 0; i < n_records; ++i) {
+        const size_t bytes = delta.leaf_bytes[i];
+        if (offset + bytes > delta.data.size()) {
+            return false;
+        }
+        const char* data = reinterpret_cast<const char*>(delta.data.data()) + offset;
+        char* record = records_.data() + i * kRecordBytes;
+        offset += bytes;
+        if (bytes == kRecordBytes) {
+            std::memcpy(record, data, kRecordBytes);
+            continue;
+        }
+        if (!blosc) {
+            return false;
+        }
+        // The Blosc header has to describe exactly this record before any byte is decompressed
+        if (bytes < BLOSC_MIN_HEADER_LENGTH) {
+            return false;
+        }
+        size_t n_bytes = 0;
+        size_t compressed_bytes = 0;
+        size_t block_size = 0;
+        blosc_cbuffer_sizes(data, &n_bytes, &compressed_bytes, &block_size);
+        if (compressed_bytes != bytes || n_bytes != kRecordBytes) {
+            return false;
+        }
+        try {
+            openvdb::io::bloscDecompress(record, kRecordBytes, kRecordBytes, data);
+        } catch (const openvdb::Exception&) {
+            return false;
+        }
+    }
+
+    const bool in_sync = delta.full || delta.version == version_ + 1;
+    version_ = delta.version;
+    if (!volume_ || delta.full) {
+        volume_.emplace(delta.voxel_size, delta.sdf_trunc, false);
+    }
+    auto& tsdf_tree = volume_->tsdf_->tree();
+    auto& weights_tree = volume_->weights_->tree();
+    for (size_t i = 0; i + 2 < delta.removed_origins.size(); i += 3) {
+        const openvdb::Coord origin(delta.removed_origins[i], delta.removed_origins[i + 1],
+                                    delta.removed_origins[i + 2]);
+        delete tsdf_tree.stealNode<LeafT>(origin, tsdf_tree.background(), false);
+        delete weights_tree.stealNode<LeafT>(origin, weights_tree.background(), false);
+    }
+    for (size_t i = 0; i < n_records; ++i) {
+        const openvdb::Coord origin(delta.leaf_origins[3 * i], delta.leaf_origins[3 * i + 1],
+                                    delta.leaf_origins[3 * i + 2]);
+        ReadRecord(records_.data() + i * kRecordBytes, *tsdf_tree.touchLeaf(origin),
+                   *weights_tree.touchLeaf(origin));
+    }
+    return in_sync;
+}
@@ -0,0 +1,117 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "Decode.hpp"
+
+#include <gtest/gtest.h>
+#include <sensor_msgs/PointCloud2.h>
+#include <sensor_msgs/PointField.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "ScanBuffer.hpp"
+
+namespace {
+sensor_msgs::PointField Field(const char* name, uint32_t offset) {
+    sensor_msgs::PointField field;
+    field.name = name;
+    field.offset = offset;
+    field.datatype = sensor_msgs::PointField::FLOAT32;
+    field.count = 1;
+    return field;
+}
+
+// One row of xyz points, 12 bytes each, in the byte order of the host or swapped
+sensor_msgs::PointCloud2 Cloud(uint32_t width, bool swapped) {
+    sensor_msgs::PointCloud2 cloud;
+    cloud.height = 1;
+    cloud.width = width;
+    cloud.fields = {Field("x", 0), Field("y", 4), Field("z", 8)};
+    cloud.point_step = 12;
+    cloud.row_step = cloud.point_step * width;
+    cloud.is_dense = true;
+    const uint16_t probe = 1;
+    uint8_t first;
+    std::memcpy(&first, &probe, 1);
+    const bool host_big_endian = first == 0;
+    cloud.is_bigendian = swapped != host_big_endian;
+    cloud.data.resize(cloud.row_step);
+    for (uint32_t i = 0; i < 3 * width; ++i) {
+        const float value = 1.0f + static_cast<float>(i);
+        uint8_t* bytes = cloud.data.data() + 4 * i;
+        std::memcpy(bytes, &value, sizeof(float));
+        if (swapped) {
+            std::reverse(bytes, bytes + sizeof(float));
+        }
+    }
+    return cloud;
+}
+}  // namespace
+
+TEST(DecodeTest, SwapsBigEndianClouds) {
+    for (const bool swapped : {false, true}) {
+        vdbfusion::ScanBuffer scan;
+        EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(Cloud(4, swapped), scan, false), 0u);
+        ASSERT_EQ(scan.size(), 4u);
+        for (size_t i = 0; i < scan.size(); ++i) {
+            EXPECT_EQ(scan.x[i], 1.0f + 3 * i);
+            EXPECT_EQ(scan.y[i], 2.0f + 3 * i);
+            EXPECT_EQ(scan.z[i], 3.0f + 3 * i);
+        }
+    }
+}
+
+TEST(DecodeTest, DropsMalformedClouds) {
+    vdbfusion::ScanBuffer scan;
+    auto short_data = Cloud(4, false);
+    short_data.data.resize(short_data.data.size() - 1);
+    EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(short_data, scan, false), 0u);
+    EXPECT_EQ(scan.size(), 0u);
+
+    auto short_rows = Cloud(4, false);
+    short_rows.row_step -= 1;
+    EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(short_rows, scan, false), 0u);
+    EXPECT_EQ(scan.size(), 0u);
+
+    auto field_overrun = Cloud(4, false);
+    field_overrun.fields[2].offset = 10;
+    EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(field_overrun, scan, false), 0u);
+    EXPECT_EQ(scan.size(), 0u);
+
+    // The largest offsets and steps must not wrap around in the bounds checks
+    auto huge_height = Cloud(4, false);
+    huge_height.height = 0xffffffffu;
+    EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(huge_height, scan, false), 0u);
+    EXPECT_EQ(scan.size(), 0u);
+
+    auto huge_offset = Cloud(4, false);
+    huge_offset.fields[0].offset = 0xfffffffeu;
+    EXPECT_EQ(vdbfusion::pcl2SensorMsgToScanBuffer(huge_offset, scan, false), 0u);
+    EXPECT_EQ(scan.size(), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
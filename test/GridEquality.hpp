@@ -0,0 +1,55 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#pragma once
+
+#include <gtest/gtest.h>
+#include <openvdb/openvdb.h>
+
+#include <cstring>
+
+namespace vdbfusion {
+
+// Same active voxels with bitwise identical values, reports the first difference
+inline ::testing::AssertionResult IdenticalGrids(const openvdb::FloatGrid& a,
+                                                 const openvdb::FloatGrid& b) {
+    if (a.activeVoxelCount() != b.activeVoxelCount()) {
+        return ::testing::AssertionFailure() << a.activeVoxelCount() << " active voxels against "
+                                             << b.activeVoxelCount();
+    }
+    auto b_acc = b.getConstAccessor();
+    for (auto value = a.cbeginValueOn(); value; ++value) {
+        const openvdb::Coord voxel = value.getCoord();
+        float b_value;
+        if (!b_acc.probeValue(voxel, b_value)) {
+            return ::testing::AssertionFailure() << "Voxel " << voxel << " is only active in one";
+        }
+        const float a_value = *value;
+        if (std::memcmp(&a_value, &b_value, sizeof(float)) != 0) {
+            return ::testing::AssertionFailure()
+                   << "Voxel " << voxel << " holds " << a_value << " against " << b_value;
+        }
+    }
+    return ::testing::AssertionSuccess();
+}
+}  // namespace vdbfusion
@@ -0,0 +1,247 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include <gtest/gtest.h>
+#include <ros/console.h>
+#include <ros/time.h>
+#include <sensor_msgs/PointCloud2.h>
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "GridEquality.hpp"
+#include "Mapper.hpp"
+#include "MapperMsgs.hpp"
+#include "SyntheticScans.hpp"
+#include "sophus/se3.hpp"
+
+// Every heap allocation of the test executable is counted
+namespace {
+std::atomic<size_t> allocations{0};
+}  // namespace
+
+void* operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size == 0 ? 1 : size)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void* operator new[](std::size_t size) { return ::operator new(size); }
+
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr) noexcept { std::free(ptr); }
+
+void operator delete(void* ptr, std::size_t /*size*/) noexcept { std::free(ptr); }
+
+void operator delete[](void* ptr, std::size_t /*size*/) noexcept { std::free(ptr); }
+
+namespace {
+sensor_msgs::PointCloud2 RenderLiDARScan(const Sophus::SE3d& T_world_sensor,
+                                         double stamp = 1.0) {
+    vdbfusion::SyntheticSensor sensor;
+    sensor.rows = 16;
+    sensor.columns = 512;
+    sensor_msgs::PointCloud2 pcd;
+    vdbfusion::RenderScan(vdbfusion::SyntheticScene(), sensor, T_world_sensor, ros::Time(stamp), 0,
+                          pcd);
+    return pcd;
+}
+
+vdbfusion::MapperConfig TestConfig() {
+    vdbfusion::MapperConfig config;
+    config.voxel_size = 0.1f;
+    config.sdf_trunc = 0.3f;
+    config.filter.min_range = 0.5f;
+    config.filter.max_range = 50.0f;
+    return config;
+}
+}  // namespace
+
+// Once the largest scan has been seen and its leaves exist, decoding, filtering and integration
+// run out of the recycled per-scan buffers
+TEST(MapperTest, SteadyStateIntegrationDoesNotAllocate) {
+    const Sophus::SE3d pose = vdbfusion::CorridorPose(vdbfusion::SyntheticScene(), 0.0, 2.0);
+    const sensor_msgs::PointCloud2 pcd = RenderLiDARScan(pose);
+    vdbfusion::Mapper mapper(TestConfig());
+    for (int i = 0; i < 3; ++i) {
+        vdbfusion::IntegrateCloud(mapper, pcd, pose);
+    }
+    const size_t before = allocations.load();
+    for (int i = 0; i < 10; ++i) {
+        vdbfusion::IntegrateCloud(mapper, pcd, pose);
+    }
+    EXPECT_EQ(allocations.load() - before, 0u);
+}
+
+// Without apply_pose the scan stays in the sensor frame, whatever pose comes with it
+TEST(MapperTest, IgnoredPoseIntegratesFromTheSensorOrigin) {
+    const sensor_msgs::PointCloud2 pcd = RenderLiDARScan(Sophus::SE3d());
+    auto config = TestConfig();
+    config.apply_pose = false;
+    vdbfusion::Mapper identity(config);
+    vdbfusion::Mapper moved(config);
+    vdbfusion::IntegrateCloud(identity, pcd, Sophus::SE3d());
+    vdbfusion::IntegrateCloud(moved, pcd,
+                              vdbfusion::CorridorPose(vdbfusion::SyntheticScene(), 3.0, 2.0));
+    const auto expected = identity.Snapshot()->ToVDBVolume();
+    const auto result = moved.Snapshot()->ToVDBVolume();
+    EXPECT_GT(expected.tsdf_->activeVoxelCount(), 0u);
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+}
+
+// The fused {tsdf, weight} grid runs vdbfusion's traversal and update rule
+TEST(MapperTest, FusedLayoutMatchesSplitLayout) {
+    const vdbfusion::SyntheticScene scene;
+    auto config = TestConfig();
+    vdbfusion::Mapper split(config);
+    config.fused_layout = true;
+    vdbfusion::Mapper fused(config);
+    for (int i = 0; i < 3; ++i) {
+        const Sophus::SE3d pose = vdbfusion::CorridorPose(scene, 0.1 * i, 2.0);
+        const sensor_msgs::PointCloud2 pcd = RenderLiDARScan(pose);
+        vdbfusion::IntegrateCloud(split, pcd, pose);
+        vdbfusion::IntegrateCloud(fused, pcd, pose);
+    }
+    const auto expected = split.Snapshot()->ToVDBVolume();
+    const auto result = fused.Snapshot()->ToVDBVolume();
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+}
+
+// Snapshots copy the leaves written since the previous one and share all the others
+TEST(MapperTest, SnapshotsCopyOnlyTheWrittenLeaves) {
+    const vdbfusion::SyntheticScene scene;
+    const Sophus::SE3d start = vdbfusion::CorridorPose(scene, 0.0, 2.0);
+    const Sophus::SE3d end = vdbfusion::CorridorPose(scene, 30.0, 2.0);
+    vdbfusion::Mapper incremental(TestConfig());
+    vdbfusion::Mapper reference(TestConfig());
+    vdbfusion::IntegrateCloud(incremental, RenderLiDARScan(start), start);
+    const auto first = incremental.Snapshot();
+    vdbfusion::IntegrateCloud(incremental, RenderLiDARScan(end), end);
+    const auto second = incremental.Snapshot();
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(start), start);
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(end), end);
+
+    const auto expected = reference.Snapshot()->ToVDBVolume();
+    const auto result = second->ToVDBVolume();
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+    // The end pose is 60 m down the corridor, beyond the range of the start pose
+    size_t n_shared = 0;
+    for (auto leaf = expected.weights_->tree().cbeginLeaf(); leaf; ++leaf) {
+        const auto* old_leaf = first->FindLeaf(leaf->origin());
+        n_shared += old_leaf != nullptr && old_leaf == second->FindLeaf(leaf->origin());
+    }
+    EXPECT_GT(n_shared, 0u);
+    EXPECT_EQ(first->version() + 1, second->version());
+}
+
+// A snapshot nobody holds any more can not be shared, the next one copies the whole map unless
+// the writer retains it
+TEST(MapperTest, DroppedSnapshotsAreCopiedAgain) {
+    const vdbfusion::SyntheticScene scene;
+    const Sophus::SE3d start = vdbfusion::CorridorPose(scene, 0.0, 2.0);
+    const Sophus::SE3d end = vdbfusion::CorridorPose(scene, 30.0, 2.0);
+    vdbfusion::Mapper reference(TestConfig());
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(start), start);
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(end), end);
+    const auto expected = reference.Snapshot()->ToVDBVolume();
+    for (const bool retain : {false, true}) {
+        auto config = TestConfig();
+        config.retain_snapshots = retain;
+        vdbfusion::Mapper mapper(config);
+        vdbfusion::IntegrateCloud(mapper, RenderLiDARScan(start), start);
+        const uint64_t first_version = mapper.Snapshot()->version();
+        vdbfusion::IntegrateCloud(mapper, RenderLiDARScan(end), end);
+        const auto second = mapper.Snapshot();
+        const auto result = second->ToVDBVolume();
+        EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+        EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+        EXPECT_EQ(first_version + 1, second->version());
+    }
+}
+
+// A scan leaving the window takes back exactly what its integration put in
+TEST(MapperTest, ExpiredScansLeaveNoTrace) {
+    const vdbfusion::SyntheticScene scene;
+    // 120 m apart, the two scans share no voxel
+    const Sophus::SE3d first = vdbfusion::CorridorPose(scene, 0.0, 2.0);
+    const Sophus::SE3d second = vdbfusion::CorridorPose(scene, 60.0, 2.0);
+    auto config = TestConfig();
+    config.window_duration = 5.0;
+    vdbfusion::Mapper window(config);
+    vdbfusion::Mapper reference(config);
+    EXPECT_TRUE(window.config().ray_packets);
+    vdbfusion::IntegrateCloud(window, RenderLiDARScan(first, 1.0), first);
+    vdbfusion::IntegrateCloud(window, RenderLiDARScan(second, 10.0), second);
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(second, 10.0), second);
+
+    const auto expected = reference.Snapshot()->ToVDBVolume();
+    const auto result = window.Snapshot()->ToVDBVolume();
+    EXPECT_GT(expected.tsdf_->activeVoxelCount(), 0u);
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+}
+
+// Leaves not updated for eviction_age go, and the snapshots stop holding them
+TEST(MapperTest, EvictionDropsStaleLowWeightLeaves) {
+    const vdbfusion::SyntheticScene scene;
+    const Sophus::SE3d first = vdbfusion::CorridorPose(scene, 0.0, 2.0);
+    const Sophus::SE3d second = vdbfusion::CorridorPose(scene, 60.0, 2.0);
+    auto config = TestConfig();
+    config.eviction = true;
+    // Every leaf counts as low weight, only the age decides
+    config.eviction_max_weight = 1e6f;
+    config.eviction_age = 5.0;
+    vdbfusion::Mapper mapper(config);
+    vdbfusion::Mapper reference(TestConfig());
+    vdbfusion::IntegrateCloud(mapper, RenderLiDARScan(first, 1.0), first);
+    EXPECT_EQ(mapper.EvictTransients(2.0).evicted_leaves, 0u);
+    EXPECT_GT(mapper.Snapshot()->size(), 0u);
+    vdbfusion::IntegrateCloud(mapper, RenderLiDARScan(second, 8.0), second);
+    vdbfusion::IntegrateCloud(reference, RenderLiDARScan(second, 8.0), second);
+
+    // Only the leaves of the first scan are older than eviction_age
+    const auto stats = mapper.EvictTransients(8.0);
+    EXPECT_GT(stats.evicted_leaves, 0u);
+    const auto expected = reference.Snapshot()->ToVDBVolume();
+    const auto result = mapper.Snapshot()->ToVDBVolume();
+    EXPECT_EQ(stats.remaining_leaves, expected.weights_->tree().leafCount());
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.tsdf_, *result.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*expected.weights_, *result.weights_));
+    EXPECT_EQ(mapper.EvictTransients(9.0).evicted_leaves, 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    // The per-scan messages of the mapper would allocate
+    if (ros::console::set_logger_level(ROSCONSOLE_DEFAULT_NAME, ros::console::levels::Warn)) {
+        ros::console::notifyLoggerLevelsChanged();
+    }
+    return RUN_ALL_TESTS();
+}
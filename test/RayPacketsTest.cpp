@@ -0,0 +1,145 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "RayPackets.hpp"
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+
+#include "GridEquality.hpp"
+#include "ScanBatch.hpp"
+#include "vdbfusion/VDBVolume.h"
+
+namespace {
+// Two scans of a wall and a floor, taken from different origins. Without an offset the origins
+// lie on voxel faces.
+vdbfusion::ScanBatch WallAndFloor(const Eigen::Vector3d& offset = Eigen::Vector3d::Zero()) {
+    vdbfusion::ScanBatch batch;
+    for (const double x : {0.0, 0.7}) {
+        const Eigen::Vector3d origin = Eigen::Vector3d(x, 0.1, 1.2) + offset;
+        auto& points = batch.Add(origin);
+        for (int i = 0; i < 360; ++i) {
+            for (int j = 0; j < 8; ++j) {
+                const double azimuth = 2.0 * M_PI * i / 360.0;
+                const double elevation = -0.4 + 0.1 * j;
+                const Eigen::Vector3d direction(std::cos(elevation) * std::cos(azimuth),
+                                                std::cos(elevation) * std::sin(azimuth),
+                                                std::sin(elevation));
+                // Walls at |x| = 6 and |y| = 4, floor at z = 0
+                double range = 50.0;
+                if (direction.z() < 0.0) {
+                    range = std::min(range, -origin.z() / direction.z());
+                }
+                range = std::min(range, (6.0 - std::copysign(origin.x(), direction.x())) /
+                                            std::abs(direction.x()));
+                range = std::min(range, (4.0 - std::copysign(origin.y(), direction.y())) /
+                                            std::abs(direction.y()));
+                points.push_back(origin + range * direction);
+            }
+        }
+    }
+    return batch;
+}
+}  // namespace
+
+// The packet width only changes how many rays are traversed at once, never the update order
+TEST(RayPacketsTest, PacketWidthDoesNotChangeTheGrids) {
+    const vdbfusion::ScanBatch batch = WallAndFloor();
+    vdbfusion::VDBVolume scalar(0.1f, 0.3f, false);
+    vdbfusion::VDBVolume packets(0.1f, 0.3f, false);
+    vdbfusion::PacketScratch scratch;
+    vdbfusion::IntegratePackets(scalar, batch, scratch, 1);
+    vdbfusion::IntegratePackets(packets, batch, scratch, vdbfusion::kPacketWidth);
+    EXPECT_GT(scalar.tsdf_->activeVoxelCount(), 0u);
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*scalar.tsdf_, *packets.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*scalar.weights_, *packets.weights_));
+}
+
+// The inlined unit weight gives the same grids as the same weighting through a std::function
+TEST(RayPacketsTest, InlinedWeightMatchesWeightingFunction) {
+    const vdbfusion::ScanBatch batch = WallAndFloor();
+    vdbfusion::VDBVolume inlined(0.1f, 0.3f, false);
+    vdbfusion::VDBVolume called(0.1f, 0.3f, false);
+    vdbfusion::PacketScratch scratch;
+    vdbfusion::IntegratePackets(inlined, batch, scratch);
+    const std::function<float(float)> unit_weight = [](float /*unused*/) { return 1.0f; };
+    vdbfusion::IntegratePackets(called, batch, unit_weight, scratch);
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*inlined.tsdf_, *called.tsdf_));
+    EXPECT_TRUE(vdbfusion::IdenticalGrids(*inlined.weights_, *called.weights_));
+}
+
+// vdbfusion traverses in single precision and the packets in double precision, so a ray whose
+// band starts or ends within rounding of a voxel face may visit one voxel more or less. The
+// offset keeps the origins off the voxel faces: a ray running inside a face plane is the one case
+// where the two paths put a whole row of voxels on different sides of the face.
+TEST(RayPacketsTest, MatchesVDBVolumeIntegrateWithinBound) {
+    const vdbfusion::ScanBatch batch = WallAndFloor(Eigen::Vector3d(0.03, 0.07, 0.034));
+    vdbfusion::VDBVolume reference(0.1f, 0.3f, false);
+    vdbfusion::VDBVolume packets(0.1f, 0.3f, false);
+    const std::function<float(float)> unit_weight = [](float /*unused*/) { return 1.0f; };
+    for (size_t scan = 0; scan < batch.size(); ++scan) {
+        reference.Integrate(batch.points[scan], batch.origins[scan], unit_weight);
+    }
+    vdbfusion::PacketScratch scratch;
+    vdbfusion::IntegratePackets(packets, batch, scratch);
+
+    size_t only_one = 0;
+    size_t other_weight = 0;
+    float max_tsdf_difference = 0.0f;
+    auto tsdf_acc = packets.tsdf_->getConstAccessor();
+    auto weights_acc = packets.weights_->getConstAccessor();
+    auto reference_weights_acc = reference.weights_->getConstAccessor();
+    for (auto value = reference.tsdf_->cbeginValueOn(); value; ++value) {
+        const openvdb::Coord voxel = value.getCoord();
+        float tsdf;
+        if (!tsdf_acc.probeValue(voxel, tsdf)) {
+            ++only_one;
+            continue;
+        }
+        // Voxels crossed by another number of rays average other contributions
+        if (weights_acc.getValue(voxel) != reference_weights_acc.getValue(voxel)) {
+            ++other_weight;
+            continue;
+        }
+        // The packets update in leaf order, the same contributions are summed in another order
+        max_tsdf_difference = std::max(max_tsdf_difference, std::abs(tsdf - *value));
+    }
+    auto reference_acc = reference.tsdf_->getConstAccessor();
+    for (auto value = packets.tsdf_->cbeginValueOn(); value; ++value) {
+        only_one += !reference_acc.isValueOn(value.getCoord());
+    }
+    const auto voxels = static_cast<double>(reference.tsdf_->activeVoxelCount());
+    EXPECT_GT(voxels, 0.0);
+    EXPECT_LE(static_cast<double>(only_one), 0.005 * voxels);
+    EXPECT_LE(static_cast<double>(other_weight), 0.02 * voxels);
+    EXPECT_LE(max_tsdf_difference, 1e-5f);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    openvdb::initialize();
+    return RUN_ALL_TESTS();
+}
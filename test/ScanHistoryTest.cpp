@@ -0,0 +1,76 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "ScanHistory.hpp"
+
+#include <gtest/gtest.h>
+
+#include <Eigen/Core>
+#include <Eigen/Geometry>
+#include <vector>
+
+#include "ScanBatch.hpp"
+#include "sophus/se3.hpp"
+
+namespace {
+Sophus::SE3d Translation(double x) {
+    return Sophus::SE3d(Eigen::Quaterniond::Identity(), Eigen::Vector3d(x, 0.0, 0.0));
+}
+
+std::vector<Eigen::Vector3d> Points(const Sophus::SE3d& pose) {
+    std::vector<Eigen::Vector3d> points;
+    for (int i = 0; i < 100; ++i) {
+        points.push_back(pose * Eigen::Vector3d(5.0, 0.1 * i - 5.0, 0.02 * i));
+    }
+    return points;
+}
+}  // namespace
+
+// Several corrections of one scan move it once, to the last of them
+TEST(ScanHistoryTest, LastCorrectionOfAScanWins) {
+    vdbfusion::ScanHistory history(0.0);
+    for (int i = 0; i < 3; ++i) {
+        auto points = Points(Translation(i));
+        history.Add(i, Translation(i), points);
+    }
+    const std::vector<vdbfusion::PoseCorrection> corrections = {
+        {1.0, Translation(1.5)}, {2.0, Translation(2.5)}, {1.0, Translation(3.0)}};
+    vdbfusion::ScanBatch removed;
+    vdbfusion::ScanBatch added;
+    EXPECT_EQ(history.Correct(corrections, 0.01, 0.1, 0.1, removed, added), 2u);
+    ASSERT_EQ(removed.size(), 2u);
+    ASSERT_EQ(added.size(), 2u);
+    // Taken out as integrated, put back at the last correction
+    EXPECT_DOUBLE_EQ(removed.origins[0].x(), 1.0);
+    EXPECT_DOUBLE_EQ(added.origins[0].x(), 3.0);
+    EXPECT_DOUBLE_EQ(removed.origins[1].x(), 2.0);
+    EXPECT_DOUBLE_EQ(added.origins[1].x(), 2.5);
+
+    // The next correction starts from the recorded pose of the last one
+    const std::vector<vdbfusion::PoseCorrection> again = {{1.0, Translation(3.0)}};
+    EXPECT_EQ(history.Correct(again, 0.01, 0.1, 0.1, removed, added), 0u);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    return RUN_ALL_TESTS();
+}
@@ -0,0 +1,88 @@
+// MIT License
+//
+// # Copyright (c) 2022 Saurabh Gupta, Ignacio Vizzo, Cyrill Stachniss, University of Bonn
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+
+#include "VolumeComparison.hpp"
+
+#include <gtest/gtest.h>
+#include <openvdb/openvdb.h>
+
+#include <Eigen/Core>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "vdbfusion/VDBVolume.h"
+
+namespace {
+// A scan of the floor z = 0 and the wall x = 6, both moved by offset
+vdbfusion::VDBVolume FloorAndWall(const Eigen::Vector3d& offset) {
+    const Eigen::Vector3d origin(0.0, 0.0, 1.2);
+    std::vector<Eigen::Vector3d> points;
+    for (int i = -60; i <= 60; ++i) {
+        for (int j = 0; j < 24; ++j) {
+            const double azimuth = M_PI * i / 180.0;
+            const double elevation = -0.6 + 0.03 * j;
+            const Eigen::Vector3d direction(std::cos(elevation) * std::cos(azimuth),
+                                            std::cos(elevation) * std::sin(azimuth),
+                                            std::sin(elevation));
+            double range = (6.0 - origin.x()) / direction.x();
+            if (direction.z() < 0.0) {
+                range = std::min(range, -origin.z() / direction.z());
+            }
+            points.push_back(origin + range * direction + offset);
+        }
+    }
+    vdbfusion::VDBVolume volume(0.1f, 0.3f, false);
+    volume.Integrate(points, origin + offset, [](float /*unused*/) { return 1.0f; });
+    return volume;
+}
+}  // namespace
+
+TEST(VolumeComparisonTest, IdenticalVolumesMatch) {
+    const auto volume = FloorAndWall(Eigen::Vector3d::Zero());
+    const auto comparison = vdbfusion::CompareVolumes(volume, volume, true, 0.0f);
+    EXPECT_GT(comparison.common_voxels, 0u);
+    EXPECT_EQ(comparison.only_in_result, 0u);
+    EXPECT_EQ(comparison.only_in_reference, 0u);
+    EXPECT_DOUBLE_EQ(comparison.jaccard, 1.0);
+    EXPECT_DOUBLE_EQ(comparison.tsdf_rms, 0.0);
+    EXPECT_GT(comparison.vertices, 0u);
+    EXPECT_LT(comparison.chamfer_mean, 0.01);
+}
+
+// Both surfaces move by 5 cm along their normals, half a voxel
+TEST(VolumeComparisonTest, ChamferDistanceFollowsTheSurfaceOffset) {
+    const auto volume = FloorAndWall(Eigen::Vector3d::Zero());
+    const auto moved = FloorAndWall(Eigen::Vector3d(0.05, 0.0, 0.05));
+    const auto comparison = vdbfusion::CompareVolumes(moved, volume, true, 0.0f);
+    EXPECT_LT(comparison.jaccard, 1.0);
+    EXPECT_GT(comparison.tsdf_rms, 0.0);
+    EXPECT_NEAR(comparison.chamfer_mean, 0.05, 0.02);
+    EXPECT_LT(comparison.unmatched_vertices, comparison.vertices / 10);
+}
+
+int main(int argc, char** argv) {
+    testing::InitGoogleTest(&argc, argv);
+    openvdb::initialize();
+    return RUN_ALL_TESTS();
+}